@@ -4,12 +4,46 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <optional>
 #include <chrono>
 #include <ctime>
 #include <fstream>
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <unordered_map>
+#include <memory>
+#include <memory_resource>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#include "TODO_Console.h"
+#include "TODO_Logger.h"
+#include "TODO_Metrics.h"
+#include "TODO_Index.h"
+#include "TODO_Store.h"
+#include "TODO_Search.h"
+#include "TODO_SharedMutex.h"
+#include "TODO_Time.h"
+
+class SnapshotFile;
+class WriteAheadLog;
+class ColdStorage;
+class ColdSet;
+struct ColdTask;
+class TaskQuery;
+struct QueryPlan;
+class ThreadPool;
+class OutputBuffer;
+class OutputFile;
+struct WalRecord;
 
 /**
  * @brief Enumeration for task urgency levels
@@ -49,6 +83,19 @@ struct Task {
      */
     Task(int taskId, const std::string& desc, Urgency urg);
     
+    /**
+     * @brief Constructor for a task with known fields
+     * @param taskId Unique identifier for the task
+     * @param desc Description of the task
+     * @param urg Urgency level of the task
+     * @param created Creation timestamp
+     * @param done Completion status
+     * 
+     * Used when copying a stored task, so the clock is not read.
+     */
+    Task(int taskId, std::string_view desc, Urgency urg,
+         std::chrono::system_clock::time_point created, bool done);
+    
     /**
      * @brief Get formatted creation time as string
      * @return Formatted date and time string (YYYY-MM-DD HH:MM:SS)
@@ -78,25 +125,898 @@ struct Task {
     bool operator<(const Task& other) const;
 };
 
+/**
+ * @brief Read-only reference to a task held inside a TodoApp
+ * 
+ * TodoApp stores tasks column by column, so there is no Task object to
+ * point at. A TaskRef gathers the fields of one stored task by value,
+ * except for the description, which is a view into the store. It is
+ * cheap to copy and follows the TaskView invalidation rules.
+ */
+struct TaskRef {
+    int id;                                              ///< Unique task identifier
+    std::string_view description;                        ///< View of the stored description
+    Urgency urgency;                                     ///< Task urgency level
+    std::chrono::system_clock::time_point createdAt;     ///< Task creation timestamp
+    bool completed;                                      ///< Task completion status
+    
+    /**
+     * @brief Copy the referenced task into a standalone Task
+     * @return Task with the same fields
+     */
+    Task toTask() const;
+};
+
+/**
+ * @brief Input of TodoApp::addTasks()
+ */
+struct NewTask {
+    std::string description;   ///< Task description text
+    Urgency urgency;           ///< Task urgency level
+};
+
+/**
+ * @brief Outcome of a batch mutation
+ * 
+ * Batch calls report through this struct instead of printing a line per
+ * task. When committed is false the write-ahead log could not be written
+ * and nothing was changed.
+ */
+struct BatchResult {
+    bool committed;              ///< Whether the batch was applied
+    size_t applied;              ///< Number of tasks added, completed or removed
+    std::vector<int> ids;        ///< IDs of the tasks changed: input order for adds, ascending otherwise
+    std::vector<int> notFound;   ///< Requested IDs that matched no task
+    std::vector<int> archived;   ///< Requested IDs of cold tasks, which cannot be changed
+};
+
+/**
+ * @brief Urgency and completion restrictions for a task query
+ * 
+ * An empty field does not restrict the query, so a default-constructed
+ * filter matches every task.
+ */
+struct TaskFilter {
+    std::optional<Urgency> urgency;   ///< Only tasks of this urgency level
+    std::optional<bool> completed;    ///< Only completed (true) or pending (false) tasks
+};
+
+/**
+ * @brief Order of a paginated task listing
+ */
+enum class PageOrder {
+    ID,         ///< Ascending ID, which is insertion order
+    PRIORITY    ///< Order of Task::operator<: highest urgency first, oldest first
+};
+
+/**
+ * @brief Position in a paginated task listing
+ *
+ * Holds the sort key of the last task of a page, so the next page seeks
+ * straight to the task after it instead of skipping an offset. A
+ * default-constructed cursor starts before the first task. Changes made
+ * between pages never shift a later page: no task is listed twice, and
+ * tasks that sort before the cursor are not listed.
+ */
+struct TaskCursor {
+    bool started = false;                  ///< Whether any task has been listed
+    bool atEnd = false;                    ///< Whether no task followed the last page
+    int id = 0;                            ///< ID of the last task listed
+    Urgency urgency = Urgency::CRITICAL;   ///< Urgency of the last task listed
+    int64_t createdAt = 0;                 ///< Creation time of the last task listed, system_clock ticks
+};
+
+/**
+ * @brief When completed tasks leave memory for an archive file
+ *
+ * See TodoApp::setRetentionPolicy(). The policy is off while completedAge
+ * is zero, or while archiveFile is empty and coldStorage is false.
+ */
+struct RetentionPolicy {
+    std::chrono::system_clock::duration completedAge{0};   ///< Archive completed tasks created longer ago
+    std::chrono::milliseconds checkInterval{60000};       ///< Time between two runs of the policy
+    std::string archiveFile;                              ///< Binary snapshot the tasks are merged into
+    bool coldStorage{false};                              ///< Move the tasks into the cold tier instead
+};
+
+class TodoApp;
+
+/**
+ * @brief Non-owning, lazily evaluated range over a subset of the live tasks
+ * 
+ * Returned by TodoApp::viewTasksByUrgency(), viewPendingTasks() and
+ * viewCompletedTasks(). Iterating yields a TaskRef for each task stored
+ * inside the TodoApp, in insertion order, without copying descriptions;
+ * only the tasks in the view are visited and size() is O(1).
+ * 
+ * @par Invalidation:
+ * A view and its iterators refer directly to the TodoApp's storage. Any
+ * call that adds, removes, completes or replaces tasks (addTask,
+ * removeTask, markCompleted, clearCompleted, loadSnapshot,
+ * importFromFile, openDataDirectory) invalidates every view of that
+ * TodoApp, and a view must not outlive it. Using an invalidated view or
+ * iterator is undefined behaviour. Read-only calls, including exports and
+ * other views, leave views valid. When other threads may write to the
+ * TodoApp, including the retention thread of setRetentionPolicy(), hold
+ * TodoApp::readLock() while the view is in use.
+ * 
+ * @par Example:
+ * @code
+ * for (const TaskRef& task : app.viewTasksByUrgency(Urgency::HIGH)) {
+ *     std::cout << task.id << " " << task.description << std::endl;
+ * }
+ * @endcode
+ */
+class TaskView {
+public:
+    static const size_t kMaxBuckets = 4;   ///< Most state buckets a view can merge
+    
+    /**
+     * @brief Forward iterator over the tasks of a view, in insertion order
+     */
+    class iterator {
+    private:
+        const TaskView* view;                              ///< View being iterated
+        OrderedIdSet::const_iterator next[kMaxBuckets];    ///< Next unvisited ID in each bucket
+        size_t currentBucket;                              ///< Bucket holding the current task
+        TaskRef current;                                   ///< Current task
+        bool atEnd;                                        ///< Whether every task was visited
+        
+        friend class TaskView;
+        explicit iterator(const TaskView* owner);
+        void settle();
+        
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TaskRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TaskRef*;
+        using reference = const TaskRef&;
+        
+        iterator() : view(nullptr), currentBucket(0), current(), atEnd(true) {}
+        
+        /// The reference is valid until the iterator is advanced
+        const TaskRef& operator*() const { return current; }
+        const TaskRef* operator->() const { return &current; }
+        iterator& operator++();
+        iterator operator++(int) { iterator previous = *this; ++*this; return previous; }
+        bool operator==(const iterator& other) const {
+            return atEnd == other.atEnd && (atEnd || current.id == other.current.id);
+        }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+    
+    iterator begin() const { return iterator(this); }
+    iterator end() const { return iterator(); }
+    
+    /**
+     * @brief Get the number of tasks in the view
+     * @return Task count, computed without iterating
+     */
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    
+private:
+    const TodoApp* app;                         ///< Application owning the tasks
+    const OrderedIdSet* buckets[kMaxBuckets];   ///< State buckets merged by the view
+    size_t bucketCount;                         ///< Number of buckets in use
+    
+    friend class TodoApp;
+    TaskView(const TodoApp* owner, const OrderedIdSet* const* sets, size_t count);
+};
+
+/**
+ * @brief Helper function to gather the fields of a stored task
+ * @param columns TaskStore or StoreSnapshot holding the task
+ * @param slot Slot of a live task
+ * @return Reference to the task
+ */
+template <typename Columns>
+TaskRef taskRefAt(const Columns& columns, size_t slot) {
+    TaskRef task;
+    task.id = columns.id(slot);
+    task.description = columns.description(slot);
+    task.urgency = static_cast<Urgency>(columns.urgencyLevel(slot));
+    task.createdAt = std::chrono::system_clock::time_point(
+        std::chrono::system_clock::duration(columns.createdAt(slot)));
+    task.completed = columns.completed(slot);
+    return task;
+}
+
+/**
+ * @brief Read-only copy of the tasks of a TodoApp at one point in time
+ * 
+ * Returned by TodoApp::snapshot(). Taking a snapshot copies no tasks: it
+ * shares the task storage, and a writer that later changes a part of the
+ * storage a snapshot still holds copies that part (4096 tasks) first.
+ * Iterating, find() and size() therefore see exactly the tasks at the
+ * time of the call, without any lock and from any thread, while writes
+ * carry on. Storage that only snapshots still refer to is freed when the
+ * last of them is destroyed.
+ * 
+ * TaskRefs obtained from a snapshot stay valid as long as the snapshot.
+ * A snapshot must be destroyed before the TodoApp it came from.
+ * 
+ * @par Example:
+ * @code
+ * TaskSnapshot tasks = app.snapshot();
+ * for (const TaskRef& task : tasks) {
+ *     std::cout << task.id << " " << task.description << std::endl;
+ * }
+ * @endcode
+ */
+class TaskSnapshot {
+public:
+    /**
+     * @brief Forward iterator over the tasks of a snapshot, in insertion order
+     */
+    class iterator {
+    private:
+        const TaskSnapshot* snapshot;   ///< Snapshot being iterated
+        size_t slot;                    ///< Slot of the current task
+        TaskRef current;                ///< Current task
+        
+        friend class TaskSnapshot;
+        iterator(const TaskSnapshot* owner, size_t start);
+        void settle();
+        
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TaskRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TaskRef*;
+        using reference = const TaskRef&;
+        
+        iterator() : snapshot(nullptr), slot(0), current() {}
+        
+        const TaskRef& operator*() const { return current; }
+        const TaskRef* operator->() const { return &current; }
+        iterator& operator++() { ++slot; settle(); return *this; }
+        iterator operator++(int) { iterator previous = *this; ++*this; return previous; }
+        bool operator==(const iterator& other) const { return slot == other.slot; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+    
+    TaskSnapshot() : nextId(1) {}
+    
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, store.slotCount()); }
+    
+    /**
+     * @brief Get the number of tasks in the snapshot
+     * @return Task count
+     */
+    size_t size() const { return store.liveCount(); }
+    bool empty() const { return size() == 0; }
+    
+    /**
+     * @brief Find a task of the snapshot by its ID
+     * @param id Unique identifier of the task to find
+     * @return Reference to the task if it existed when the snapshot was taken
+     * 
+     * Tasks are stored in ID order, so this is a binary search.
+     */
+    std::optional<TaskRef> find(int id) const;
+    
+private:
+    StoreSnapshot store;   ///< Shared task storage at capture time
+    int nextId;            ///< TodoApp's next free ID at capture time
+    
+    friend class TodoApp;
+    TaskSnapshot(StoreSnapshot tasks, int nextFreeId) : store(std::move(tasks)), nextId(nextFreeId) {}
+    
+    /**
+     * @brief Visit the live tasks in a range of slots
+     * @param begin First slot to visit
+     * @param end One past the last slot to visit
+     * @param func Callable invoked with a TaskRef for each task
+     */
+    template <typename Func>
+    void forEachInSlots(size_t begin, size_t end, Func func) const {
+        for (size_t slot = begin; slot < end; ++slot) {
+            if (!store.isRemoved(slot)) {
+                func(taskRefAt(store, slot));
+            }
+        }
+    }
+};
+
 /**
  * @brief Main TODO Application class
  * 
  * The core class that manages all TODO application functionality including
  * task management, logging, export/import operations, and statistics.
  * Provides a complete interface for task manipulation and data persistence.
+ * 
+ * @par Thread safety:
+ * Every public member function may be called from several threads at
+ * once. Read-only calls (get*, display*, find*, search*, topK) share a
+ * reader-writer lock, so they run in parallel with each other. Exports,
+ * displayTasks() and saveSnapshot() work on a snapshot() instead and
+ * hold the lock only while taking it, so they never block writers.
+ * A mutation is split in two: it is first ordered under a short writer
+ * mutex, which allocates IDs and appends the WAL record, then waits for
+ * the WAL fsync without holding any lock, so concurrent writers share
+ * one fsync. Finally it takes the lock exclusively just long enough to
+ * apply the change, in the same order as the WAL.
+ * Views and TaskRefs point into the task storage, so use them while
+ * holding readLock().
  */
 class TodoApp {
 private:
-    std::vector<Task> tasks;    ///< Container for all tasks
-    int nextId;                 ///< Next available task ID
-    std::string logFileName;    ///< Name of the log file for action logging
+    friend class TaskView;
+    
+    std::unique_ptr<std::pmr::memory_resource> ownedMemory; ///< Default pool, null if the caller supplied one
+    CountingMemoryResource countedMemory;    ///< Counts the bytes of ownedMemory or the caller's resource in use
+    std::pmr::memory_resource* memory;       ///< Allocator for task storage and the ID index
+    TaskStore store;                         ///< Columnar storage for all tasks (insertion order)
+    std::pmr::unordered_map<int, size_t> idIndex; ///< Maps task ID to its slot in store
+    std::atomic<int> nextId;                 ///< Next available task ID
+    std::string logFileName;                 ///< Name of the log file for action logging
+    mutable MetricsRegistry registry;        ///< Operation counters and latencies, see metrics()
+    std::unique_ptr<ActionLogger> logger;    ///< Background writer for the action log
+    std::unique_ptr<WriteAheadLog> wal;      ///< Durable mutation log, null without a data directory
+    std::string dataDirectory;               ///< Directory holding checkpoints and WAL segments
+    std::unique_ptr<ColdStorage> cold;       ///< Segments of old completed tasks, null without a cold directory
+    mutable std::unique_ptr<ThreadPool> workers; ///< Import/export threads, started on first use
+    mutable std::string logScratch;          ///< Reused buffer for per-task log messages
+    OrderedIdSet stateBuckets[4][2];         ///< Live task IDs by urgency and completion state
+    PrioritySet priorityBuckets[4][2];       ///< Same tasks as stateBuckets, in priority order
+    TextIndex searchIndex;                   ///< Description terms of every task, for searchTasks()
+    mutable std::once_flag workersStarted;   ///< Guards the lazy creation of workers
+    std::atomic<OutputSink*> sink;           ///< Receives messages and displayed tables
+    
+    // Concurrency control, see the class description
+    mutable WriterPriorityMutex stateMutex;  ///< Shared by readers, exclusive while a change is applied
+    std::mutex writeMutex;                   ///< Orders writers; guards wal, dataDirectory and issuedTickets
+    std::mutex turnMutex;                    ///< Guards appliedTickets
+    std::condition_variable turnCondition;   ///< Signals that appliedTickets advanced
+    uint64_t issuedTickets;                  ///< Writes ordered so far
+    uint64_t appliedTickets;                 ///< Writes applied or abandoned so far
+    
+    bool compactionWanted;                      ///< Tombstones are waiting to be reclaimed, guarded by stateMutex
+    
+    // Background retention, see setRetentionPolicy()
+    std::mutex retentionMutex;                  ///< Guards retentionThread and retention
+    std::condition_variable retentionCondition; ///< Wakes the retention thread
+    std::thread retentionThread;                ///< Applies the retention policy, started by setRetentionPolicy()
+    std::atomic<bool> retentionStopping;        ///< Set by the destructor
+    RetentionPolicy retention;                  ///< Archiving of old completed tasks, off by default
+    std::mutex coldMutex;                       ///< Orders moves into the cold tier; taken before writeMutex
+    
+    /**
+     * @brief Exclusive access to the task state for one ordered write
+     * 
+     * Waits until every write with an earlier ticket is done, then holds
+     * stateMutex exclusively. The destructor advances a pending
+     * compaction by one slice, releases the lock and hands the turn to
+     * the next ticket, also for writes abandoned because their WAL commit
+     * failed.
+     */
+    class WriteTurn {
+    private:
+        TodoApp& app;                                ///< Application being written
+        uint64_t ticket;                             ///< Position of the write in the order
+        std::unique_lock<WriterPriorityMutex> state;   ///< Exclusive lock on the task state
+        
+    public:
+        WriteTurn(TodoApp& owner, uint64_t writeTicket);
+        ~WriteTurn();
+    };
+    
+    /**
+     * @brief Helper function to wait until every ordered write is done
+     * 
+     * Requires writeMutex, so no new writes can be ordered meanwhile.
+     * Afterwards nothing modifies the task state until writeMutex is
+     * released, and it may be read without stateMutex.
+     */
+    void drainWrites();
+    
+    /**
+     * @brief Helper function to gather the fields of a stored task
+     * @param slot Slot of a live task
+     * @return Reference to the task
+     */
+    TaskRef taskAt(size_t slot) const {
+        return taskRefAt(store, slot);
+    }
+    
+    /**
+     * @brief Helper function to visit the live tasks after a cursor in ID order
+     * @param after Cursor of the last task already visited
+     * @param levels Bit i selects urgency level i + 1
+     * @param states Bit 0 selects pending tasks, bit 1 completed tasks
+     * @param func Callable invoked with a TaskRef for each task,
+     *             returning false to stop early
+     *
+     * Without restrictions this binary-searches the slot after the cursor
+     * and walks the store from there; otherwise it seeks in the selected
+     * state buckets and merges them, so skipped tasks are never visited.
+     */
+    template <typename Func>
+    void forEachTaskAfterId(const TaskCursor& after, unsigned levels, unsigned states, Func func) const {
+        if (after.started && after.id == std::numeric_limits<int>::max()) return;
+        int firstId = after.started ? after.id + 1 : std::numeric_limits<int>::min();
+        if (levels == 0xFu && states == 3u) {
+            size_t end = store.slotCount();
+            for (size_t slot = slotsOfIds(firstId, std::numeric_limits<int>::max()).first; slot < end; ++slot) {
+                if (!store.isRemoved(slot) && !func(taskAt(slot))) return;
+            }
+            return;
+        }
+        const OrderedIdSet* sets[8];
+        OrderedIdSet::const_iterator next[8];
+        size_t count = 0;
+        for (size_t level = 0; level < 4; ++level) {
+            for (size_t state = 0; state < 2; ++state) {
+                if (!(levels & (1u << level)) || !(states & (1u << state))) continue;
+                sets[count] = &stateBuckets[level][state];
+                next[count] = sets[count]->lower_bound(firstId);
+                count++;
+            }
+        }
+        while (true) {
+            size_t lowest = count;
+            for (size_t i = 0; i < count; ++i) {
+                if (next[i] != sets[i]->end() && (lowest == count || *next[i] < *next[lowest])) {
+                    lowest = i;
+                }
+            }
+            if (lowest == count) return;
+            if (!func(taskAt(idIndex.find(*next[lowest])->second))) return;
+            ++next[lowest];
+        }
+    }
+
+    /**
+     * @brief Helper function to visit the live tasks after a cursor in priority order
+     * @param after Cursor of the last task already visited
+     * @param levels Bit i selects urgency level i + 1
+     * @param states Bit 0 selects pending tasks, bit 1 completed tasks
+     * @param func Callable invoked with a TaskRef for each task,
+     *             returning false to stop early
+     *
+     * Walks the urgency levels from the cursor's down to LOW and, within
+     * each level, merges the selected priority buckets by creation time,
+     * so the order matches Task::operator< (ties broken by ID) without
+     * sorting. The cursor's level is entered by seeking past its key.
+     */
+    template <typename Func>
+    void forEachTaskByPriorityAfter(const TaskCursor& after, unsigned levels, unsigned states, Func func) const {
+        size_t startLevel = after.started ? static_cast<size_t>(after.urgency) : 4;
+        for (size_t level = startLevel; level-- > 0;) {   // CRITICAL down to LOW
+            if (!(levels & (1u << level))) continue;
+            PriorityKey from{std::numeric_limits<int64_t>::min(), std::numeric_limits<int>::min()};
+            if (after.started && level + 1 == startLevel) {
+                from = after.id < std::numeric_limits<int>::max()
+                    ? PriorityKey{after.createdAt, after.id + 1}
+                    : PriorityKey{after.createdAt + 1, std::numeric_limits<int>::min()};
+            }
+            const PrioritySet& open = priorityBuckets[level][0];
+            const PrioritySet& done = priorityBuckets[level][1];
+            PrioritySet::const_iterator nextOpen = (states & 1u) ? open.lower_bound(from) : open.end();
+            PrioritySet::const_iterator nextDone = (states & 2u) ? done.lower_bound(from) : done.end();
+            while (nextOpen != open.end() || nextDone != done.end()) {
+                bool takeOpen = nextDone == done.end() ||
+                                (nextOpen != open.end() && *nextOpen < *nextDone);
+                PrioritySet::const_iterator& next = takeOpen ? nextOpen : nextDone;
+                if (!func(taskAt(idIndex.find((*next).id)->second))) return;
+                ++next;
+            }
+        }
+    }
+    
+    /**
+     * @brief Helper function to visit the priority keys of a creation time range
+     * @param fromTicks Earliest creation time to include, system_clock ticks
+     * @param toTicks Creation time to stop before, system_clock ticks
+     * @param levels Bit i selects urgency level i + 1
+     * @param states Bit 0 selects pending tasks, bit 1 completed tasks
+     * @param func Callable invoked with the PriorityKey of each task,
+     *             oldest first, returning false to stop early
+     * 
+     * The priority buckets are ordered by creation time, so this seeks to
+     * fromTicks in each selected bucket and merges them up to toTicks.
+     * Tasks imported with older timestamps sit in order as well.
+     */
+    template <typename Func>
+    void forEachKeyCreatedBetween(int64_t fromTicks, int64_t toTicks, unsigned levels,
+                                  unsigned states, Func func) const {
+        const PrioritySet* sets[8];
+        PrioritySet::const_iterator next[8];
+        size_t count = 0;
+        for (size_t level = 0; level < 4; ++level) {
+            for (size_t state = 0; state < 2; ++state) {
+                if (!(levels & (1u << level)) || !(states & (1u << state))) continue;
+                sets[count] = &priorityBuckets[level][state];
+                next[count] = sets[count]->lower_bound(PriorityKey{fromTicks, std::numeric_limits<int>::min()});
+                count++;
+            }
+        }
+        while (true) {
+            size_t oldest = count;
+            for (size_t i = 0; i < count; ++i) {
+                if (next[i] != sets[i]->end() && (*next[i]).createdAt < toTicks &&
+                    (oldest == count || *next[i] < *next[oldest])) {
+                    oldest = i;
+                }
+            }
+            if (oldest == count) return;
+            if (!func(*next[oldest])) return;
+            ++next[oldest];
+        }
+    }
+    
+    /**
+     * @brief Helper function to visit the tasks created in a time range
+     * @param from Earliest creation time to include
+     * @param to Creation time to stop before
+     * @param filter Urgency and completion restrictions
+     * @param func Callable invoked with a TaskRef for each task, oldest
+     *             first, returning false to stop early
+     */
+    template <typename Func>
+    void forEachTaskCreatedBetween(std::chrono::system_clock::time_point from,
+                                   std::chrono::system_clock::time_point to,
+                                   const TaskFilter& filter, Func func) const {
+        unsigned levels = filter.urgency ? 1u << (static_cast<int>(*filter.urgency) - 1) : 0xFu;
+        unsigned states = filter.completed ? (*filter.completed ? 2u : 1u) : 3u;
+        forEachKeyCreatedBetween(static_cast<int64_t>(from.time_since_epoch().count()),
+                                 static_cast<int64_t>(to.time_since_epoch().count()), levels, states,
+                                 [this, &func](const PriorityKey& key) {
+                                     return func(taskAt(idIndex.find(key.id)->second));
+                                 });
+    }
+    
+    /**
+     * @brief Helper function to choose how to answer a query
+     * @param query Query to plan
+     * @param text The query's search terms, parsed
+     * @return Plan reading the fewest candidate tasks
+     * 
+     * Requires stateMutex. Defined in TODO_Query.cc.
+     */
+    QueryPlan planQueryLocked(const TaskQuery& query, const TextQuery& text) const;
+    
+    /**
+     * @brief Helper function to display one page of all tasks
+     * @param title Title of the table
+     * @param order Order of the listing
+     * @param pageSize Maximum number of tasks on the page
+     * @param after Cursor returned for the previous page
+     * @return Cursor to pass for the next page
+     */
+    TaskCursor displayPage(std::string_view title, PageOrder order, size_t pageSize,
+                           const TaskCursor& after) const;
+    
+    /**
+     * @brief Helper function to find the slots of an ID range
+     * @param firstId Smallest ID of the range
+     * @param lastId Largest ID of the range
+     * @return First slot and one past the last slot that can hold those IDs
+     */
+    std::pair<size_t, size_t> slotsOfIds(int firstId, int lastId) const;
+    
+    /**
+     * @brief Helper function to get the priority bucket for an urgency and completion state
+     * @param urgency Urgency level
+     * @param completed Completion state
+     * @return Set of the live tasks in that state, in priority order
+     */
+    PrioritySet& priorityBucketFor(Urgency urgency, bool completed);
+    
+    /**
+     * @brief Helper function to get the bucket for an urgency and completion state
+     * @param urgency Urgency level
+     * @param completed Completion state
+     * @return Set of the live task IDs in that state
+     */
+    OrderedIdSet& bucketFor(Urgency urgency, bool completed);
+    const OrderedIdSet& bucketFor(Urgency urgency, bool completed) const;
+    
+    /**
+     * @brief Helper function to add a task at the end of the store
+     * @param id Task ID, must be greater than every ID in use
+     * @param description Description of the task
+     * @param urgency Urgency level of the task
+     * @param createdAt Creation timestamp of the task
+     * @param completed Completion status of the task
+     * 
+     * Updates the ID index, the state buckets and the search index. Does
+     * not log, print or write to the WAL.
+     */
+    void appendTask(int id, std::string_view description, Urgency urgency,
+                    std::chrono::system_clock::time_point createdAt, bool completed);
+    
+    /**
+     * @brief Helper function behind both addTask() overloads
+     * @param description Text description of the task
+     * @param urgency Urgency level of the task
+     */
+    void insertTask(std::string_view description, Urgency urgency);
+    
+    /**
+     * @brief Helper function to resolve batch IDs to slots
+     * @param ids Requested task IDs
+     * @param result Receives the IDs that match no task and the IDs of cold tasks
+     * @return Slots of the matching tasks in ascending order, without duplicates
+     */
+    std::vector<size_t> resolveSlots(const std::vector<int>& ids, BatchResult& result) const;
+    
+    /**
+     * @brief Helper function to mark the task in a slot as completed
+     * @param slot Slot index of the task
+     * 
+     * Moves the task to the completed bucket of its urgency. Does not
+     * log, print or write to the WAL.
+     */
+    void completeSlot(size_t slot);
+    
+    /**
+     * @brief Helper function to drop every task and reset the next ID
+     */
+    void resetTasks();
+    
+    /**
+     * @brief Helper function to get the worker threads, starting them if needed
+     * @return Pool shared by imports and exports
+     */
+    ThreadPool& workerPool() const;
+    
+    /**
+     * @brief Helper function to format chunks of tasks and write them in order
+     * @param file Output file, already holding any header
+     * @param chunkCount Number of chunks to format
+     * @param chunkBytes Initial buffer size of a chunk
+     * @param formatChunk Appends the tasks of one chunk to a buffer
+     * @param trimFirst Bytes dropped from the start of the first non-empty output
+     * 
+     * With more than one chunk the chunks are formatted on the worker
+     * threads, each into its own buffer, while the calling thread writes
+     * the finished buffers to the file in order. trimFirst lets formats
+     * that put a separator before every record (such as the comma between
+     * JSON objects) drop the one before the first record wherever it lands.
+     */
+    void writeTaskChunks(OutputFile& file, size_t chunkCount, size_t chunkBytes,
+                         const std::function<void(OutputBuffer&, size_t)>& formatChunk,
+                         size_t trimFirst) const;
+    
+    /**
+     * @brief Helper function to cut the hot and cold tasks into ranges of IDs
+     * @param tasks Hot tasks
+     * @param coldTasks Cold tasks
+     * @return Ascending bounds; chunk i holds the IDs in [bounds[i], bounds[i + 1])
+     * 
+     * Each chunk holds up to a few ranges of kExportChunkSlots slots.
+     */
+    std::vector<int64_t> exportChunks(const TaskSnapshot& tasks, const ColdSet& coldTasks) const;
+    
+    /**
+     * @brief Helper function to export hot and cold tasks in ID order
+     * @param file Output file, already holding any header
+     * @param tasks Hot tasks
+     * @param coldTasks Cold tasks
+     * @param appendRecord Called with a chunk's buffer and each task
+     * @param trimFirst As for writeTaskChunks()
+     * 
+     * Each chunk merges its hot and cold tasks by ID. A task in both
+     * tiers, left by a crash during moveToColdStorage(), is written once,
+     * from the hot tier. Defined in TODO_App.cc.
+     */
+    template <typename AppendRecord>
+    void writeTasks(OutputFile& file, const TaskSnapshot& tasks, const ColdSet& coldTasks,
+                    AppendRecord appendRecord, size_t trimFirst) const;
+    
+    /**
+     * @brief Helper function to write every task in one export format
+     * @param filename Name of the output file
+     * @return true if the file was written, false otherwise
+     * 
+     * Format is one of the policies in TODO_Export.h; it supplies the
+     * header, footer and per-column appends, which the record writer
+     * unrolls over kExportSchema. Defined in TODO_App.cc.
+     */
+    template <typename Format>
+    bool exportTasks(const std::string& filename) const;
+    
+    /**
+     * @brief Helper function to capture the hot and cold tasks at the same time
+     * @param coldTasks Receives the cold segments in use, empty without a cold directory
+     * @return Snapshot of the hot tasks
+     */
+    TaskSnapshot snapshotWithCold(ColdSet& coldTasks) const;
+    
+    /**
+     * @brief Helper function to convert a task read from a cold segment
+     * @param task Cold task
+     * @return Reference to the task, with the description still in the segment
+     */
+    static TaskRef coldTaskRef(const ColdTask& task);
+    
+    /**
+     * @brief Helper function to look up a task in the cold tier
+     * @param id Task ID
+     * @param task Receives the task if found
+     * @return true if a cold segment holds the ID
+     * 
+     * Requires stateMutex, held shared or exclusively.
+     */
+    bool findColdTask(int id, TaskRef& task) const;
+    
+    /**
+     * @brief Helper function to read the first cold tasks after a cursor in ID order
+     * @param after Cursor of the last task already visited
+     * @param levels Bit i selects urgency level i + 1
+     * @param states Bit 0 selects pending tasks, bit 1 completed tasks
+     * @param limit Maximum number of tasks to read
+     * @param tasks Receives the matching cold tasks, skipping IDs that are still hot
+     * 
+     * Requires stateMutex, held shared. The TaskRefs point into the
+     * mapped segments and stay valid while the lock is held.
+     */
+    void coldTasksAfterId(const TaskCursor& after, unsigned levels, unsigned states, size_t limit,
+                          std::vector<TaskRef>& tasks) const;
+    
+    /**
+     * @brief Helper function to merge matching cold tasks into a result
+     * @param tasks Hot tasks, sorted by ID or by creation time
+     * @param levels Bit i selects urgency level i + 1
+     * @param states Bit 0 selects pending tasks, bit 1 completed tasks
+     * @param fromTicks Earliest creation time, system_clock ticks
+     * @param toTicks Creation time to stop before
+     * @param creationOrder Whether tasks is ordered by creation time and ID rather than ID
+     * 
+     * Requires stateMutex, held shared. Scans the cold segments that can
+     * hold a match and skips IDs that are still hot.
+     */
+    void mergeColdTasks(std::vector<Task>& tasks, unsigned levels, unsigned states,
+                        int64_t fromTicks, int64_t toTicks, bool creationOrder) const;
+    
+    /**
+     * @brief Helper function to tombstone the task stored in a slot
+     * @param slot Slot index of the task to remove
+     * 
+     * Drops the task from the ID index and the buckets, but leaves the
+     * slot in place so that removal never shifts later tasks.
+     */
+    void tombstoneSlot(size_t slot);
+    
+    /**
+     * @brief Helper function to reclaim a slice of the tombstoned slots
+     * @return true while the compaction pass has slots left to examine
+     * 
+     * Requires the exclusive state lock. Starts a pass of the store's
+     * compaction if compactionWanted is set and tombstones exist, then
+     * advances it by a bounded number of slots: live tasks move down over
+     * tombstoned slots, preserving insertion order, the descriptions of
+     * removed tasks are freed at the end of the pass, and the ID index is
+     * updated for every task that moved. Prunes the search index when a
+     * pass ends and removed tasks make up half of it.
+     */
+    bool compactSliceLocked();
+    
+    /**
+     * @brief Body of the retention thread
+     * 
+     * Applies the retention policy every checkInterval until the
+     * TodoApp is destroyed.
+     */
+    void retentionLoop();
+    
+    /**
+     * @brief Helper function to write an archive of completed tasks
+     * @param filename Archive snapshot, merged with the new tasks if it exists
+     * @param tasks Snapshot holding the tasks to add
+     * @param ids IDs of the tasks to add, ascending
+     * @return true once the merged archive has replaced the old one and
+     *         the rename is synced to the directory
+     */
+    bool writeArchive(const std::string& filename, const TaskSnapshot& tasks,
+                      const std::vector<int>& ids) const;
+    
+    /**
+     * @brief Helper function to remove the task stored in a slot
+     * @param slot Slot index of the task to remove
+     * 
+     * Tombstones the slot and sets compactionWanted once tombstones make
+     * up half of the store, keeping removal amortized O(1).
+     */
+    void removeSlot(size_t slot);
+    
+    /**
+     * @brief Helper function to remove every completed task
+     * @return Number of tasks removed
+     * 
+     * Does not log, print or write to the WAL.
+     */
+    size_t clearCompletedTasks();
+    
+    /**
+     * @brief Helper function to wait for a WAL record to become durable
+     * @param sequence Sequence number of the appended record
+     * @return true if the record is durable and the change may be applied
+     * 
+     * Reports an error message when the WAL can no longer be written.
+     */
+    bool commitToWal(uint64_t sequence);
+    
+    /**
+     * @brief Helper function to apply a recovered WAL record
+     * @param record Record read back from a WAL segment
+     * 
+     * Applies the mutation without logging, printing or writing to the WAL.
+     */
+    void applyWalRecord(const WalRecord& record);
+    
+    /**
+     * @brief Helper function to checkpoint once the WAL has grown large
+     */
+    void checkpointIfNeeded();
+    
+    /**
+     * @brief Helper function behind checkpoint()
+     * @return true if the checkpoint was written
+     * 
+     * Requires writeMutex with every write drained.
+     */
+    bool checkpointLocked();
+    
+    /**
+     * @brief Helper function behind loadSnapshot()
+     * @param filename Name of the snapshot file
+     * @return true if the snapshot was loaded
+     * 
+     * Requires writeMutex with every write drained.
+     */
+    bool loadSnapshotLocked(const std::string& filename);
+    
+    /**
+     * @brief Helper function to count pending or completed tasks
+     * @param completed Which state to count
+     * @return Sum of the state bucket sizes
+     */
+    size_t countTasks(bool completed) const;
+    
+    /**
+     * @brief Helper function to write a snapshot tied to a WAL position
+     * @param filename Name of the output snapshot file
+     * @param tasks Tasks to write
+     * @param walSequence Last WAL sequence the snapshot covers
+     * @return true if the snapshot was written
+     */
+    bool writeSnapshot(const std::string& filename, const TaskSnapshot& tasks, uint64_t walSequence) const;
+    
+    /**
+     * @brief Helper function to append a task read from an external source
+     * @param id Task ID found in the source
+     * @param description Description of the task
+     * @param urgency Urgency level of the task
+     * @param createdAt Original creation timestamp of the task
+     * @param completed Original completion status of the task
+     * @return The ID the task was stored under
+     * 
+     * Keeps the original ID when it is greater than every ID in use, so
+     * that tasks stay in ascending ID order, and assigns the next free
+     * ID otherwise. Does not log or print anything.
+     */
+    int appendImportedTask(int id, std::string_view description, Urgency urgency,
+                           std::chrono::system_clock::time_point createdAt, bool completed);
+    
+    /**
+     * @brief Helper function to append every task of a mapped snapshot
+     * @param snapshot Validated snapshot to read from
+     * @return Number of tasks appended
+     */
+    size_t appendSnapshotTasks(const SnapshotFile& snapshot);
     
     /**
      * @brief Helper function to get current timestamp string
      * @return Current date and time as formatted string
      * 
      * Private utility function that generates a timestamp string
-     * in YYYY-MM-DD HH:MM:SS format for logging purposes.
+     * in YYYY-MM-DD HH:MM:SS format for logging purposes, through the
+     * thread-safe formatLocalTimestamp().
      */
     std::string getCurrentTimestamp() const;
     
@@ -104,28 +1024,72 @@ private:
      * @brief Helper function to log actions
      * @param action Description of the action to log
      * 
-     * Private utility function that writes timestamped action logs
-     * to the specified log file for audit trail purposes.
+     * Private utility function that queues a timestamped action log entry
+     * for the background logger, which appends it to the log file for
+     * audit trail purposes. Never opens the file or blocks on I/O.
      */
-    void logAction(const std::string& action) const;
+    void logAction(std::string action) const;
+    
+    /**
+     * @brief Helper function to log an action on a single task
+     * @param action Verb that starts the entry, e.g. "Added"
+     * @param id Task ID
+     * @param description Task description
+     * @param urgency Urgency name to append, or empty for none
+     * 
+     * Formats into logScratch and swaps it into the logger, so the
+     * add/remove/complete path does not allocate a string per entry.
+     */
+    void logTaskAction(std::string_view action, int id, std::string_view description,
+                       std::string_view urgency = std::string_view()) const;
 
 public:
     /**
      * @brief Constructor for TodoApp
      * @param logFile Name of the log file (default: "todo_log.txt")
+     * @param syncPolicy When the action log is fsynced (default: on shutdown only)
+     * @param memoryResource Allocator for task storage, descriptions and the
+     *                       ID index (default: a pool owned by the app)
      * 
      * Initializes the TODO application with the specified log file.
-     * Sets up the initial state and logs the application startup.
+     * Starts the background action logger, sets up the initial state
+     * and logs the application startup.
+     * 
+     * The default std::pmr::unsynchronized_pool_resource recycles the
+     * memory of removed tasks for new ones, so steady add/remove churn
+     * does not reach malloc. A caller-supplied resource must outlive the
+     * app; a monotonic resource suits load-once workloads, since it never
+     * reuses freed memory.
      */
-    TodoApp(const std::string& logFile = "todo_log.txt");
+    TodoApp(const std::string& logFile = "todo_log.txt",
+            const LogSyncPolicy& syncPolicy = LogSyncPolicy(),
+            std::pmr::memory_resource* memoryResource = nullptr);
     
     /**
      * @brief Destructor for TodoApp
      * 
-     * Cleans up resources and logs the application termination.
+     * Logs the application termination, then stops the action logger
+     * after every queued entry has been written and synced according
+     * to the sync policy.
      */
     ~TodoApp();
     
+    /**
+     * @brief Choose where messages and displayed tables go
+     * @param outputSink Sink to use from now on; it must outlive its use by this TodoApp
+     * 
+     * The default is consoleSink(). Library and server code that has no
+     * console passes nullSink(), which makes the reporting of every call
+     * free of formatting.
+     */
+    void setOutputSink(OutputSink& outputSink);
+    
+    /**
+     * @brief Get the sink messages and displayed tables go to
+     * @return Current sink
+     */
+    OutputSink& outputSink() const { return *sink.load(std::memory_order_acquire); }
+    
     // Core functionality
     
     /**
@@ -135,17 +1099,33 @@ public:
      * 
      * Creates a new task with the given description and urgency level.
      * Automatically assigns a unique ID and sets the creation timestamp.
-     * Logs the action and provides user feedback.
+     * Logs the action and reports TaskEvent::ADDED to the output sink.
      */
     void addTask(const std::string& description, Urgency urgency);
     
+    /**
+     * @brief Add a new task, taking over the description string
+     * @param description Text description of the task, left empty
+     * @param urgency Urgency level of the task
+     * 
+     * Same as the copying overload. The description is stored in the
+     * task arena either way; this overload lets callers hand over a
+     * temporary without binding it to a const reference.
+     */
+    void addTask(std::string&& description, Urgency urgency);
+    
     /**
      * @brief Remove a task by its ID
      * @param id Unique identifier of the task to remove
      * 
-     * Searches for and removes the task with the specified ID.
-     * Logs the action and provides appropriate user feedback.
-     * If the task is not found, displays an error message.
+     * Looks up the task through the ID index and tombstones its slot, so
+     * removal costs the same regardless of the number of tasks. Tombstoned
+     * slots are reclaimed once they make up half of the store.
+     * Logs the action and reports TaskEvent::REMOVED to the output sink,
+     * TaskEvent::ARCHIVED if the task is in the cold tier, which is left
+     * unchanged, or TaskEvent::NOT_FOUND if no task has the ID. The event
+     * tells what happened when the removal was applied, so of several
+     * racing removals of one task only the first reports REMOVED.
      */
     void removeTask(int id);
     
@@ -154,28 +1134,174 @@ public:
      * @param id Unique identifier of the task to mark as completed
      * 
      * Finds the task with the specified ID and marks it as completed.
-     * Logs the action and provides user feedback. If the task is not
-     * found, displays an error message.
+     * Logs the action and reports TaskEvent::COMPLETED to the output
+     * sink, TaskEvent::ARCHIVED if the task is in the cold tier, where
+     * every task is already completed, or TaskEvent::NOT_FOUND if no task
+     * has the ID, also when a racing removal got to it first.
      */
     void markCompleted(int id);
     
+    // Batch mutations
+    
+    /**
+     * @brief Add several tasks at once
+     * @param tasks Descriptions and urgency levels of the new tasks
+     * @return IDs assigned to the tasks, in input order
+     * 
+     * Assigns consecutive IDs and one creation time to the whole batch,
+     * writes a single write-ahead log record and a single action log
+     * entry, and prints nothing.
+     */
+    BatchResult addTasks(const std::vector<NewTask>& tasks);
+    
+    /**
+     * @brief Mark several tasks as completed at once
+     * @param ids IDs of the tasks to complete
+     * @return IDs completed by this call, IDs that were not found and IDs of cold tasks
+     * 
+     * Resolves every ID before changing anything, skips tasks that are
+     * already completed or listed twice, and writes a single write-ahead
+     * log record and action log entry. Prints nothing.
+     * Cold tasks are already completed and are left unchanged.
+     */
+    BatchResult markCompletedBatch(const std::vector<int>& ids);
+    
+    /**
+     * @brief Remove several tasks at once
+     * @param ids IDs of the tasks to remove
+     * @return IDs removed, IDs that were not found and IDs of cold tasks
+     * 
+     * Resolves and tombstones every task, then compacts the store at most
+     * once for the whole batch instead of once per removal. Writes a single
+     * write-ahead log record and action log entry. Prints nothing.
+     * Cold tasks are left in their segments.
+     */
+    BatchResult removeTasks(const std::vector<int>& ids);
+    
     /**
      * @brief Display all tasks in a formatted table
      * 
      * Shows all tasks (both completed and pending) in a tabular format
      * with columns for ID, description, urgency, creation time, and status.
-     * If no tasks exist, displays an appropriate message.
+     * Works on a snapshot() merged by ID with the cold tier, and streams
+     * the table to the output sink every 4096 rows, so memory stays
+     * bounded however many tasks there are.
+     * If no tasks exist, sends a message instead.
      */
     void displayTasks() const;
-    
+
     /**
      * @brief Display tasks sorted by urgency level
-     * 
+     *
      * Shows all tasks sorted by urgency (highest priority first),
      * with secondary sorting by creation time. Uses the same tabular
-     * format as displayTasks().
+     * format as displayTasks(). The order is maintained incrementally,
+     * so nothing is copied or sorted. Rows are rendered 4096 at a time
+     * under the shared lock and written after releasing it, so writers
+     * only wait for one page; changes between pages are handled as
+     * described for TaskCursor. Like visitPage() in priority order, it
+     * lists the hot tasks only.
      */
     void displayTasksSortedByUrgency() const;
+
+    /**
+     * @brief Display one page of all tasks in ID order
+     * @param pageSize Maximum number of tasks on the page
+     * @param after Cursor returned for the previous page, default for the first page
+     * @return Cursor to pass for the next page
+     *
+     * Same table as displayTasks(), limited to the page. The page after
+     * the cursor is found by binary search, so any page costs
+     * O(log n + pageSize) however many pages came before it. Sends a
+     * message instead if the page is empty.
+     */
+    TaskCursor displayTasksPage(size_t pageSize, const TaskCursor& after = TaskCursor()) const;
+
+    /**
+     * @brief Display one page of all tasks sorted by urgency level
+     * @param pageSize Maximum number of tasks on the page
+     * @param after Cursor returned for the previous page, default for the first page
+     * @return Cursor to pass for the next page
+     *
+     * Same table as displayTasksSortedByUrgency(), limited to the page.
+     * The cursor's priority key is looked up in the priority order, so
+     * earlier pages are never visited.
+     */
+    TaskCursor displayTasksSortedByUrgencyPage(size_t pageSize, const TaskCursor& after = TaskCursor()) const;
+
+    /**
+     * @brief Visit one page of a task listing
+     * @param order Order of the listing
+     * @param after Cursor returned for the previous page of the same
+     *              listing, default for the first page
+     * @param pageSize Maximum number of tasks to visit
+     * @param filter Urgency and completion restrictions
+     * @param func Callable invoked with a TaskRef for each task of the page
+     * @return Cursor after the last task visited; atEnd tells whether
+     *         more tasks followed
+     *
+     * Seeks straight to the first matching task after the cursor, so a
+     * page costs O(log n + pageSize) and earlier pages are never visited.
+     * Pages in ID order merge in the cold tier, read through its block
+     * index; pages in priority order cover the hot tasks only.
+     * Like visitTaskById(), func runs under the shared lock, must not
+     * call back into the TodoApp, and must not keep the TaskRefs.
+     *
+     * @par Example:
+     * @code
+     * TaskFilter pending;
+     * pending.completed = false;
+     * TaskCursor cursor;
+     * do {
+     *     cursor = app.visitPage(PageOrder::PRIORITY, cursor, 100, pending,
+     *                            [](const TaskRef& task) { std::cout << task.id << std::endl; });
+     * } while (!cursor.atEnd);
+     * @endcode
+     */
+    template <typename Func>
+    TaskCursor visitPage(PageOrder order, const TaskCursor& after, size_t pageSize,
+                         const TaskFilter& filter, Func func) const {
+        MetricsRegistry::Timer timer(registry, MetricOp::QUERY, 0);
+        unsigned levels = filter.urgency ? 1u << (static_cast<int>(*filter.urgency) - 1) : 0xFu;
+        unsigned states = filter.completed ? (*filter.completed ? 2u : 1u) : 3u;
+        TaskCursor cursor = after;
+        cursor.atEnd = true;
+        size_t visited = 0;
+        auto visit = [&](const TaskRef& task) {
+            if (visited == pageSize) {
+                cursor.atEnd = false;   // One more task exists; it starts the next page
+                return false;
+            }
+            func(task);
+            visited++;
+            cursor.started = true;
+            cursor.id = task.id;
+            cursor.urgency = task.urgency;
+            cursor.createdAt = static_cast<int64_t>(task.createdAt.time_since_epoch().count());
+            return true;
+        };
+        std::shared_lock<WriterPriorityMutex> state(stateMutex);
+        if (order == PageOrder::ID) {
+            // One cold task more than the page tells whether another page follows
+            std::vector<TaskRef> coldTasks;
+            coldTasksAfterId(after, levels, states,
+                             pageSize < std::numeric_limits<size_t>::max() ? pageSize + 1 : pageSize, coldTasks);
+            size_t nextCold = 0;
+            forEachTaskAfterId(after, levels, states, [&](const TaskRef& task) {
+                while (nextCold < coldTasks.size() && coldTasks[nextCold].id < task.id) {
+                    if (!visit(coldTasks[nextCold++])) return false;
+                }
+                return visit(task);
+            });
+            while (nextCold < coldTasks.size() && visit(coldTasks[nextCold])) {
+                nextCold++;
+            }
+        } else {
+            forEachTaskByPriorityAfter(after, levels, states, visit);
+        }
+        timer.setItems(visited);
+        return cursor;
+    }
     
     // Search and filter functions
     
@@ -186,6 +1312,8 @@ public:
      * 
      * Returns a copy of all tasks that have the specified urgency level.
      * The returned vector can be empty if no matching tasks are found.
+     * Only the matching tasks are visited. Prefer viewTasksByUrgency()
+     * when the copies are not needed.
      */
     std::vector<Task> getTasksByUrgency(Urgency urgency) const;
     
@@ -207,61 +1335,277 @@ public:
      */
     std::vector<Task> getPendingTasks() const;
     
+    /**
+     * @brief View the tasks of one urgency level without copying them
+     * @param urgency The urgency level to filter by
+     * @return Lazy view of the matching tasks, in insertion order
+     * 
+     * See TaskView for when the view is invalidated.
+     */
+    TaskView viewTasksByUrgency(Urgency urgency) const;
+    
+    /**
+     * @brief View all completed tasks without copying them
+     * @return Lazy view of the completed tasks, in insertion order
+     * 
+     * See TaskView for when the view is invalidated.
+     */
+    TaskView viewCompletedTasks() const;
+    
+    /**
+     * @brief View all pending tasks without copying them
+     * @return Lazy view of the pending tasks, in insertion order
+     * 
+     * See TaskView for when the view is invalidated.
+     */
+    TaskView viewPendingTasks() const;
+    
+    /**
+     * @brief Get the most urgent pending tasks
+     * @param count Maximum number of tasks to return
+     * @return Up to count pending tasks in the order of Task::operator<
+     * 
+     * Highest urgency first, oldest first within an urgency level, ties
+     * broken by ID. Runs in O(count): the priority order is maintained by
+     * every mutator, so only the returned tasks are visited.
+     * 
+     * @par Example:
+     * @code
+     * for (const Task& task : app.topK(50)) {
+     *     std::cout << task.id << " " << task.description << std::endl;
+     * }
+     * @endcode
+     */
+    std::vector<Task> topK(size_t count) const;
+    
+    /**
+     * @brief Find the tasks whose descriptions contain every word of a query
+     * @param query Words to look for, e.g. "report draft*"
+     * @param limit Maximum number of tasks to return
+     * @return Matching tasks in insertion order
+     * 
+     * Words are runs of letters and digits and match case-insensitively;
+     * a word ending in '*' matches every word that starts with it. The
+     * query is answered from an inverted index that every mutator keeps
+     * up to date, by intersecting the compressed ID lists of the words,
+     * so no description is scanned. Cold tasks, which are not indexed,
+     * are matched by scanning their descriptions. An empty query matches
+     * nothing.
+     * 
+     * @par Example:
+     * @code
+     * for (const Task& task : app.searchTasks("groc* list", 20)) {
+     *     std::cout << task.id << " " << task.description << std::endl;
+     * }
+     * @endcode
+     */
+    std::vector<Task> searchTasks(const std::string& query,
+                                  size_t limit = std::numeric_limits<size_t>::max()) const;
+    
+    // Combined queries
+    
+    /**
+     * @brief Run a query that combines several filters
+     * @param query Restrictions, order and limit of the result
+     * @return Matching tasks in the query's order
+     * 
+     * Reads the candidates from the most selective index for the query
+     * (an ID range, the search index, the creation time order or the
+     * urgency/state sets), checks the remaining restrictions against the
+     * task columns and intersects search terms with their posting lists,
+     * and copies only the tasks that are returned. When the candidates
+     * arrive in the requested order a limit ends the scan early;
+     * otherwise the first tasks are kept in a bounded heap. Cold segments
+     * that can hold a match are scanned as well and their rows join the
+     * heap. Defined in TODO_Query.cc.
+     */
+    std::vector<Task> runQuery(const TaskQuery& query) const;
+    
+    /**
+     * @brief Show how runQuery() would answer a query
+     * @param query Query to plan
+     * @return Chosen index and estimated number of candidates
+     */
+    QueryPlan planQuery(const TaskQuery& query) const;
+    
+    // Age queries
+    
+    /**
+     * @brief Get the tasks created in a time range
+     * @param from Earliest creation time to include
+     * @param to Creation time to stop before
+     * @param filter Urgency and completion restrictions (default: none)
+     * @return Matching tasks, oldest first, ties broken by ID
+     * 
+     * Runs in O(log n) plus the number of tasks returned: the tasks of
+     * every urgency level and state are kept ordered by creation time,
+     * and only the buckets that pass the filter are searched.
+     */
+    std::vector<Task> getTasksCreatedBetween(std::chrono::system_clock::time_point from,
+                                             std::chrono::system_clock::time_point to,
+                                             const TaskFilter& filter = TaskFilter()) const;
+    
+    /**
+     * @brief Get the tasks created more than a given time ago
+     * @param age Minimum age of the tasks
+     * @param filter Urgency and completion restrictions (default: none)
+     * @return Matching tasks, oldest first
+     * 
+     * @par Example:
+     * @code
+     * TaskFilter pending;
+     * pending.completed = false;
+     * auto overdue = app.getTasksOlderThan(std::chrono::hours(24 * 7), pending);
+     * @endcode
+     */
+    std::vector<Task> getTasksOlderThan(std::chrono::system_clock::duration age,
+                                        const TaskFilter& filter = TaskFilter()) const;
+    
+    /**
+     * @brief Get the tasks created within a given time before now
+     * @param age Maximum age of the tasks
+     * @param filter Urgency and completion restrictions (default: none)
+     * @return Matching tasks, oldest first
+     */
+    std::vector<Task> getTasksCreatedWithin(std::chrono::system_clock::duration age,
+                                            const TaskFilter& filter = TaskFilter()) const;
+    
     // Export functions
     
     /**
      * @brief Export tasks to plain text file
      * @param filename Name of the output file
+     * @param format How creation times are written
      * @return true if export successful, false otherwise
      * 
      * Exports all tasks to a human-readable plain text format.
      * Includes all task details with clear formatting and separators.
      * Logs the export action upon success.
      */
-    bool exportToFile(const std::string& filename) const;
+    bool exportToFile(const std::string& filename, TimestampFormat format = TimestampFormat::LOCAL) const;
     
     /**
      * @brief Export tasks to CSV format
      * @param filename Name of the output CSV file
+     * @param format How creation times are written; importFromFile() reads either
      * @return true if export successful, false otherwise
      * 
      * Exports all tasks to CSV format suitable for spreadsheet applications.
-     * Includes headers and properly quoted fields. Logs the export action
+     * Includes headers and quotes the description, doubling any quotes in
+     * it, so importFromFile() reads back descriptions with commas, quotes
+     * and line breaks. Large exports are
+     * formatted in parallel on worker threads. Logs the export action
      * upon success.
      */
-    bool exportToCSV(const std::string& filename) const;
+    bool exportToCSV(const std::string& filename, TimestampFormat format = TimestampFormat::LOCAL) const;
     
     /**
      * @brief Export tasks to JSON format
      * @param filename Name of the output JSON file
+     * @param format How times are written: a string for LOCAL, a number for
+     *               EPOCH; importFromFile() reads either
      * @return true if export successful, false otherwise
      * 
      * Exports all tasks to JSON format suitable for web applications
-     * and APIs. Includes metadata such as export timestamp.
-     * Logs the export action upon success.
+     * and APIs. Includes metadata such as export timestamp. Quotes,
+     * backslashes and control characters in descriptions are escaped.
+     * Large exports are formatted in parallel on worker threads. Logs the
+     * export action upon success.
+     */
+    bool exportToJSON(const std::string& filename, TimestampFormat format = TimestampFormat::LOCAL) const;
+    
+    /**
+     * @brief Export tasks as newline-delimited JSON
+     * @param filename Name of the output file
+     * @param format How times are written, as for exportToJSON()
+     * @return true if export successful, false otherwise
+     * 
+     * Writes one compact JSON object per task and line, with the fields
+     * and escaping of exportToJSON() but no enclosing document, so the
+     * file can be streamed and appended to. importFromFile() reads it
+     * back. Logs the export action upon success.
+     */
+    bool exportToNDJSON(const std::string& filename, TimestampFormat format = TimestampFormat::LOCAL) const;
+    
+    /**
+     * @brief Save all tasks to a binary snapshot
+     * @param filename Name of the output snapshot file
+     * @return true if the snapshot was written, false otherwise
+     * 
+     * Writes every task, including its original ID, creation time and
+     * status, in the fixed-layout format described by SnapshotHeader.
+     * The file is replaced atomically, so an interrupted save never
+     * leaves a partial snapshot behind. Logs the action upon success.
+     */
+    bool saveSnapshot(const std::string& filename) const;
+    
+    /**
+     * @brief Replace all tasks with the contents of a binary snapshot
+     * @param filename Name of the snapshot file
+     * @return true if the snapshot was loaded, false otherwise
+     * 
+     * Memory-maps the snapshot and rebuilds the task list and ID index
+     * directly from its records, restoring the next available ID. The
+     * current tasks are left untouched if the file is not a valid snapshot.
      */
-    bool exportToJSON(const std::string& filename) const;
+    bool loadSnapshot(const std::string& filename);
     
     /**
      * @brief Import tasks from file
      * @param filename Name of the input file
      * @return true if import successful, false otherwise
      * 
-     * @note This function is declared but not implemented in the current version
-     * 
-     * Placeholder for future functionality to import tasks from
-     * external files. Would support the reverse operation of export functions.
+     * Appends the tasks stored in a binary snapshot, or in a CSV or JSON
+     * file written by exportToCSV()/exportToJSON(), to the current tasks.
+     * Text files are streamed in chunks and parsed on worker threads, and
+     * records that cannot be parsed are skipped and counted. Imported
+     * tasks keep their creation time and status; they also keep their ID
+     * unless it is not greater than every ID already in use, in which case
+     * a new ID is assigned. Importing a snapshot into an empty application
+     * is equivalent to loadSnapshot(). Logs the action upon success.
      */
     bool importFromFile(const std::string& filename);
     
+    // Durability functions
+    
+    /**
+     * @brief Make all task mutations durable in a data directory
+     * @param directory Directory for checkpoints and the write-ahead log
+     * @return true if the directory is ready, false otherwise
+     * 
+     * Creates the directory if needed and recovers its state: the newest
+     * readable checkpoint snapshot is loaded and every later WAL record is
+     * replayed, replacing the current tasks. A torn record left by a crash
+     * ends the replay and is cut off. From then on every addTask,
+     * removeTask, markCompleted and clearCompleted appends one binary
+     * record to the WAL and returns only once it is fsynced; concurrent
+     * writers share a single fsync through group commit. If the directory
+     * holds no state yet, the current tasks are checkpointed into it.
+     */
+    bool openDataDirectory(const std::string& directory);
+    
+    /**
+     * @brief Write a checkpoint and start a new WAL segment
+     * @return true if the checkpoint was written, false otherwise
+     * 
+     * Saves every task to a snapshot that records the last WAL sequence it
+     * covers, then deletes the snapshots and WAL segments it supersedes.
+     * Runs automatically once the WAL reaches 64 MiB, and after bulk
+     * loads that the WAL cannot express. Requires openDataDirectory().
+     */
+    bool checkpoint();
+    
     // Utility functions
     
     /**
      * @brief Clear all completed tasks
      * 
      * Removes all tasks that have been marked as completed from the
-     * task list. Provides feedback on the number of tasks removed.
+     * task list and compacts the remaining tasks in a single pass.
+     * Provides feedback on the number of tasks removed.
      * Logs the cleanup action with the count of removed tasks.
+     * Only tasks in memory are cleared; completed tasks in the cold tier
+     * stay there and are still counted.
      */
     void clearCompleted();
     
@@ -270,7 +1614,7 @@ public:
      * @return Total count of tasks (completed and pending)
      * 
      * Returns the total number of tasks currently in the application,
-     * regardless of their completion status.
+     * regardless of their completion status, the cold tier included.
      */
     int getTotalTasks() const;
     
@@ -279,7 +1623,8 @@ public:
      * @return Count of tasks that are not completed
      * 
      * Returns the number of tasks that still need to be completed.
-     * Useful for progress tracking and workload assessment.
+     * Useful for progress tracking and workload assessment. O(1).
+     * Includes the cold tier, which only holds completed tasks.
      */
     int getPendingTasksCount() const;
     
@@ -288,7 +1633,8 @@ public:
      * @return Count of tasks that have been completed
      * 
      * Returns the number of tasks that have been marked as completed.
-     * Useful for productivity tracking and progress reports.
+     * Useful for productivity tracking and progress reports. O(1).
+     * Includes the completed tasks in the cold tier.
      */
     int getCompletedTasksCount() const;
     
@@ -297,20 +1643,163 @@ public:
      * 
      * Shows detailed statistics including total, pending, and completed
      * task counts, as well as a breakdown of pending tasks by urgency level.
-     * Provides a comprehensive overview of the current task status.
+     * Provides a comprehensive overview of the current task status, sent to
+     * the output sink in a single write. The totals include the cold
+     * tier, which is also listed on its own line.
      */
     void displayStatistics() const;
+
+    /**
+     * @brief Get the operation counters, latencies and gauges
+     * @return Metrics merged from every thread that called into the app
+     *
+     * Adds, removals, completions, queries and exports are counted on
+     * every call, with a sample of their latencies, and so are the action
+     * log's batch writes. The gauges are the task counts in memory, the
+     * size of the cold tier, the bytes allocated for task storage, and
+     * the process's resident memory. Unlike getTotalTasks(), the task
+     * gauges leave out the cold tier, so tasks plus coldTasks is the total.
+     * Write it out with appendPrometheus().
+     */
+    MetricsSnapshot metrics() const;
+
+    /**
+     * @brief Reclaim the slots of removed tasks now
+     * 
+     * Removals, clearCompleted() included, only tombstone tasks, which
+     * takes time proportional to the tasks removed. Once tombstones make
+     * up half of the store, every following write moves the remaining
+     * tasks over them by a slice of a few thousand slots before it
+     * returns, so no call waits for a whole pass over the store and tasks
+     * only move when the TodoApp is written to. This runs the rest of the
+     * pass on the calling thread, e.g. to measure memory after clearing
+     * when no more writes follow.
+     */
+    void compactStorage();
+
+    /**
+     * @brief Move old completed tasks from memory into an archive file
+     * @param age Completed tasks created longer ago than this are archived
+     * @param archiveFile Binary snapshot the tasks are merged into, created if missing
+     * @return true if nothing was old enough or the tasks were archived
+     *         and removed, false if the archive could not be written
+     * 
+     * The archive is written, fsynced, renamed into place and its
+     * directory synced before the tasks are removed through the WAL, so a
+     * crash never loses a task.
+     * It keeps the format of saveSnapshot(), so loadSnapshot() or
+     * importFromFile() bring the tasks back. Logs the action upon success.
+     */
+    bool archiveCompletedTasks(std::chrono::system_clock::duration age, const std::string& archiveFile);
+
+    /**
+     * @brief Archive old completed tasks in the background
+     * @param policy Age, archive file and interval; see RetentionPolicy
+     * 
+     * A retention thread, started on the first call, runs
+     * archiveCompletedTasks(), or moveToColdStorage() when
+     * policy.coldStorage is set, every checkInterval, so the tasks kept in
+     * memory stay bounded by the pending work and recent history. Those
+     * runs write to the TodoApp from that thread, so views and TaskRefs
+     * need TodoApp::readLock() while a policy is set.
+     */
+    void setRetentionPolicy(const RetentionPolicy& policy);
     
+    /**
+     * @brief Open a directory of cold segments as a second, read-only tier
+     * @param directory Directory holding cold-<sequence>.seg files, created if missing
+     * @return true if every segment could be opened, false otherwise
+     * 
+     * Cold tasks stay on disk and are read through the page cache, so
+     * they take no task storage. findTaskById(), visitTaskById(), the
+     * urgency, completion and age filters, searchTasks(), runQuery(), the
+     * counts, the statistics, displayTasks() and the text, CSV and JSON
+     * exports list hot and cold tasks together, and so do pages in ID
+     * order. Views, pages in priority order, topK(), snapshots,
+     * checkpoints and the task gauges of metrics() cover the hot tasks
+     * only. Cold tasks are read-only: removeTask() and
+     * markCompleted() report TaskEvent::ARCHIVED for them, the batch
+     * variants list them in BatchResult::archived, and clearCompleted()
+     * leaves them in place. New IDs are kept above every cold ID.
+     */
+    bool openColdStorage(const std::string& directory);
+    
+    /**
+     * @brief Move old completed tasks from memory into the cold tier
+     * @param age Completed tasks created longer ago than this are moved
+     * @return true if nothing was old enough or the tasks were moved,
+     *         false without a cold directory or if a segment or the
+     *         removal could not be written
+     * 
+     * Writes the tasks, at most 65536 per segment, into a new immutable
+     * segment that is fsynced before they are removed through the WAL.
+     * Writers wait while a segment is written, so no change to the tasks
+     * can slip in between; readers do not. Once more than eight segments
+     * exist, the smaller half is merged into one. Logs the action upon
+     * success. If the removal cannot be logged, the segment stays on disk
+     * and the tasks stay in memory, so a crash can leave a task in both
+     * tiers but never in neither.
+     */
+    bool moveToColdStorage(std::chrono::system_clock::duration age);
+
     /**
      * @brief Find a task by its ID
      * @param id Unique identifier of the task to find
-     * @return Pointer to the task if found, nullptr otherwise
+     * @return Reference to the task if found, empty otherwise
      * 
-     * Searches for a task with the specified ID and returns a pointer
-     * to it if found. Returns nullptr if no task with the given ID exists.
-     * The returned pointer can be used to modify the task directly.
+     * Looks up the task through the ID index in constant time, then in
+     * the cold tier, if one is open, through its bloom filters. The result
+     * is read-only, since changing a task behind the indexes' back would
+     * leave them stale; use markCompleted() and removeTask() instead. It
+     * follows the TaskView invalidation rules.
+     */
+    std::optional<TaskRef> findTaskById(int id) const;
+
+    /**
+     * @brief Call a function with a task while writers are locked out
+     * @param id Unique identifier of the task to visit
+     * @param func Callable invoked with the task's TaskRef if it exists
+     * @return true if the task was found and visited, false otherwise
+     *
+     * Lets a caller read a task in place, e.g. to encode it, without
+     * copying it or holding readLock() itself. func must not call back
+     * into the TodoApp.
      */
-    Task* findTaskById(int id);
+    template <typename Func>
+    bool visitTaskById(int id, Func func) const {
+        MetricsRegistry::Timer timer(registry, MetricOp::QUERY, 0);
+        std::shared_lock<WriterPriorityMutex> state(stateMutex);
+        auto it = idIndex.find(id);
+        TaskRef task;
+        if (it != idIndex.end()) {
+            task = taskAt(it->second);
+        } else if (!findColdTask(id, task)) {
+            return false;
+        }
+        timer.setItems(1);
+        func(task);
+        return true;
+    }
+
+    /**
+     * @brief Lock out writers while using views or TaskRefs
+     * @return Shared lock on the task state; writes wait until it is released
+     * 
+     * Read-only member functions lock on their own; this is only needed
+     * to keep the result of a view or findTaskById() valid while other
+     * threads write. Do not call mutating member functions while holding it.
+     */
+    std::shared_lock<WriterPriorityMutex> readLock() const;
+    
+    /**
+     * @brief Capture the current tasks for reading without locks
+     * @return Snapshot of every task at the time of the call
+     * 
+     * Holds the read lock only while sharing the storage, which costs a
+     * reference per 4096 tasks. Writers never wait for a snapshot once it
+     * is taken. See TaskSnapshot.
+     */
+    TaskSnapshot snapshot() const;
 };
 
 // Utility functions for urgency conversion
@@ -331,6 +1820,15 @@ public:
  */
 std::string urgencyToString(Urgency urgency);
 
+/**
+ * @brief Get the name of an urgency level without allocating
+ * @param urgency The urgency level
+ * @return View of a static string, "UNKNOWN" for invalid urgency values
+ * 
+ * Same text as urgencyToString(), for hot paths such as the exporters.
+ */
+std::string_view urgencyName(Urgency urgency);
+
 /**
  * @brief Convert string to urgency enum
  * @param urgencyStr String representation of urgency level
@@ -0,0 +1,558 @@
+#include "TODO_ColdStore.h"
+#include "TODO_Snapshot.h"
+#include "TODO_WAL.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kColdMagic[8] = {'T', 'O', 'D', 'O', 'C', 'O', 'L', 'D'};
+const size_t kFlushBytes = 1 << 20;      // Write the pending blocks once they reach 1 MiB
+const size_t kBloomBitsPerTask = 10;     // About 1% false positives with kBloomHashes
+const uint32_t kBloomHashes = 7;         // Bits set per ID
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const char*& in, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in != end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*in++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Differences of creation times wrap around, so any two times encode
+uint64_t zigzag(uint64_t difference) {
+    return (difference << 1) ^ (0 - (difference >> 63));
+}
+
+uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+// splitmix64 finalizer; the two halves drive double hashing
+uint64_t hashId(int id) {
+    uint64_t x = static_cast<uint32_t>(id) + 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+template <typename Func>
+void forEachBloomBit(int id, uint64_t bits, uint32_t hashes, Func func) {
+    uint64_t hash = hashId(id);
+    uint64_t h1 = hash & 0xFFFFFFFFu;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < hashes; ++i) {
+        if (!func((h1 + i * h2) % bits)) return;
+    }
+}
+
+std::string segmentPath(const std::string& directory, uint64_t sequence) {
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%020llu", static_cast<unsigned long long>(sequence));
+    return directory + "/cold-" + digits + ".seg";
+}
+
+// Parse the sequence of a name like "cold-<digits>.seg"
+bool parseSegmentName(const std::string& name, uint64_t& sequence) {
+    static const std::string prefix = "cold-";
+    static const std::string suffix = ".seg";
+    if (name.size() <= prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = prefix.size(); i < name.size() - suffix.size(); ++i) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(name[i] - '0');
+    }
+    sequence = value;
+    return true;
+}
+
+} // namespace
+
+// ColdSegmentWriter Implementation
+ColdSegmentWriter::ColdSegmentWriter(const std::string& filename, size_t expectedTasks)
+    : targetName(filename), tempName(filename + ".tmp"), fd(-1), failed(false),
+      fileOffset(sizeof(ColdSegmentHeader)), blockTasks(0), lastId(0), lastCreatedAtNs(0) {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kColdMagic, sizeof(kColdMagic));
+    header.version = kColdSegmentVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.minCreatedAtNs = std::numeric_limits<int64_t>::max();
+    header.maxCreatedAtNs = std::numeric_limits<int64_t>::min();
+    header.bloomHashes = kBloomHashes;
+    bloom.assign(std::max<size_t>(1, (expectedTasks * kBloomBitsPerTask + 63) / 64), 0);
+    header.bloomWords = bloom.size();
+    output.reserve(kFlushBytes * 2);
+
+    fd = ::open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    failed = fd < 0;
+}
+
+ColdSegmentWriter::~ColdSegmentWriter() {
+    if (fd >= 0) {
+        ::close(fd);
+        ::unlink(tempName.c_str());
+    }
+}
+
+void ColdSegmentWriter::add(int id, std::string_view description, uint8_t urgency,
+                            int64_t createdAtNs, bool completed) {
+    if (failed) return;
+
+    if (blockTasks == 0) {
+        ColdBlockEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.firstId = id;
+        entry.offset = fileOffset + output.size();
+        index.push_back(entry);
+        lastId = id;
+        lastCreatedAtNs = 0;
+    }
+    putVarint(block, static_cast<uint32_t>(id - lastId));
+    putVarint(block, zigzag(static_cast<uint64_t>(createdAtNs) - static_cast<uint64_t>(lastCreatedAtNs)));
+    block.push_back(static_cast<char>(urgency | (completed ? 8 : 0)));
+    putVarint(block, description.size());
+    block.append(description.data(), description.size());
+    lastId = id;
+    lastCreatedAtNs = createdAtNs;
+    index.back().lastId = id;
+
+    if (header.taskCount == 0) header.minId = id;
+    header.maxId = id;
+    header.taskCount++;
+    header.completedCount += completed ? 1 : 0;
+    header.levelCounts[urgency - 1]++;
+    header.minCreatedAtNs = std::min(header.minCreatedAtNs, createdAtNs);
+    header.maxCreatedAtNs = std::max(header.maxCreatedAtNs, createdAtNs);
+    uint64_t bits = bloom.size() * 64;
+    forEachBloomBit(id, bits, kBloomHashes, [this](uint64_t bit) {
+        bloom[bit / 64] |= 1ull << (bit % 64);
+        return true;
+    });
+
+    if (++blockTasks == kColdBlockTasks) finishBlock();
+}
+
+void ColdSegmentWriter::finishBlock() {
+    ColdBlockEntry& entry = index.back();
+    entry.size = static_cast<uint32_t>(block.size());
+    entry.checksum = crc32(block.data(), block.size());
+    output.append(block);
+    block.clear();
+    blockTasks = 0;
+    if (output.size() >= kFlushBytes) flushOutput();
+}
+
+void ColdSegmentWriter::flushOutput() {
+    if (!failed && !pwriteAll(fd, output.data(), output.size(), fileOffset)) {
+        failed = true;
+    }
+    fileOffset += output.size();
+    output.clear();
+}
+
+bool ColdSegmentWriter::finish() {
+    if (fd < 0) return false;
+    if (blockTasks > 0) finishBlock();
+
+    // The index is read in place, so it starts on an 8-byte boundary
+    output.append((8 - (fileOffset + output.size()) % 8) % 8, '\0');
+    flushOutput();
+    if (header.taskCount == 0) {
+        header.minCreatedAtNs = 0;
+        header.maxCreatedAtNs = 0;
+    }
+    header.blockCount = index.size();
+    header.indexOffset = fileOffset;
+    header.bloomOffset = fileOffset + index.size() * sizeof(ColdBlockEntry);
+    output.append(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ColdBlockEntry));
+    output.append(reinterpret_cast<const char*>(bloom.data()), bloom.size() * sizeof(uint64_t));
+    header.indexChecksum = crc32(output.data(), output.size());
+    flushOutput();
+
+    int file = fd;
+    fd = -1;
+    return commitFile(file, &header, sizeof(header), !failed, tempName, targetName);
+}
+
+// ColdSegment Implementation
+ColdSegment::ColdSegment()
+    : base(nullptr), mappedSize(0), header(nullptr), index(nullptr), bloom(nullptr) {}
+
+ColdSegment::~ColdSegment() {
+    close();
+}
+
+void ColdSegment::close() {
+    if (base) {
+        ::munmap(const_cast<char*>(base), mappedSize);
+    }
+    base = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+    index = nullptr;
+    bloom = nullptr;
+}
+
+bool ColdSegment::open(const std::string& filename) {
+    close();
+    errorMessage.clear();
+    path = filename;
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        errorMessage = "could not open " + filename;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ColdSegmentHeader)) {
+        ::close(fd);
+        errorMessage = filename + " is too small to be a cold segment";
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        errorMessage = "could not map " + filename;
+        return false;
+    }
+    base = static_cast<const char*>(mapping);
+    mappedSize = fileSize;
+
+    const ColdSegmentHeader* candidate = reinterpret_cast<const ColdSegmentHeader*>(base);
+    if (std::memcmp(candidate->magic, kColdMagic, sizeof(kColdMagic)) != 0) {
+        errorMessage = filename + " is not a cold segment";
+    } else if (candidate->byteOrder != kSnapshotByteOrder) {
+        errorMessage = filename + " was written with a different byte order";
+    } else if (candidate->version != kColdSegmentVersion) {
+        errorMessage = filename + " uses unsupported cold segment version " +
+                       std::to_string(candidate->version);
+    } else if (candidate->indexOffset % 8 != 0 || candidate->indexOffset > fileSize ||
+               candidate->blockCount > (fileSize - candidate->indexOffset) / sizeof(ColdBlockEntry) ||
+               candidate->bloomOffset != candidate->indexOffset + candidate->blockCount * sizeof(ColdBlockEntry) ||
+               candidate->bloomWords == 0 ||
+               candidate->bloomWords > (fileSize - candidate->bloomOffset) / sizeof(uint64_t) ||
+               candidate->bloomHashes == 0 || candidate->bloomHashes > 32) {
+        errorMessage = filename + " is truncated";
+    } else if (crc32(base + candidate->indexOffset,
+                     static_cast<size_t>(candidate->bloomOffset - candidate->indexOffset +
+                                         candidate->bloomWords * sizeof(uint64_t))) != candidate->indexChecksum) {
+        errorMessage = filename + " has a corrupt index";
+    } else {
+        header = candidate;
+        index = reinterpret_cast<const ColdBlockEntry*>(base + header->indexOffset);
+        bloom = reinterpret_cast<const uint64_t*>(base + header->bloomOffset);
+        for (size_t i = 0; i < header->blockCount; ++i) {
+            const ColdBlockEntry& entry = index[i];
+            if (entry.firstId > entry.lastId || (i > 0 && entry.firstId <= index[i - 1].lastId) ||
+                entry.offset < sizeof(ColdSegmentHeader) || entry.offset > header->indexOffset ||
+                entry.size > header->indexOffset - entry.offset) {
+                errorMessage = filename + " has a corrupt index entry at block " + std::to_string(i);
+                break;
+            }
+        }
+    }
+
+    if (!errorMessage.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ColdSegment::verify() const {
+    size_t blocks = header ? static_cast<size_t>(header->blockCount) : 0;
+    for (size_t i = 0; i < blocks; ++i) {
+        if (crc32(base + index[i].offset, index[i].size) != index[i].checksum) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColdSegment::mayContain(int id) const {
+    if (!header || header->taskCount == 0 || id < header->minId || id > header->maxId) {
+        return false;
+    }
+    bool present = true;
+    forEachBloomBit(id, header->bloomWords * 64, header->bloomHashes, [this, &present](uint64_t bit) {
+        present = (bloom[bit / 64] >> (bit % 64)) & 1;
+        return present;
+    });
+    return present;
+}
+
+bool ColdSegment::find(int id, ColdTask& task) const {
+    if (!mayContain(id)) {
+        return false;
+    }
+    Cursor cursor = seek(id);
+    while (cursor.read(task)) {
+        if (task.id >= id) return task.id == id;
+    }
+    return false;
+}
+
+ColdSegment::Cursor ColdSegment::seek(int firstId) const {
+    size_t blocks = header ? static_cast<size_t>(header->blockCount) : 0;
+    const ColdBlockEntry* found = std::partition_point(index, index + blocks,
+        [firstId](const ColdBlockEntry& entry) { return entry.lastId < firstId; });
+    return Cursor(*this, static_cast<size_t>(found - index));
+}
+
+void ColdSegment::splitIds(size_t taskStep, std::vector<int>& ids) const {
+    size_t blocks = header ? static_cast<size_t>(header->blockCount) : 0;
+    size_t stride = std::max<size_t>(1, taskStep / kColdBlockTasks);
+    for (size_t block = stride; block < blocks; block += stride) {
+        ids.push_back(index[block].firstId);
+    }
+}
+
+// ColdSegment::Cursor Implementation
+ColdSegment::Cursor::Cursor(const ColdSegment& owner, size_t blockIndex)
+    : segment(&owner), block(0), next(nullptr), blockEnd(nullptr), id(0), createdAtNs(0) {
+    enterBlock(blockIndex);
+}
+
+void ColdSegment::Cursor::enterBlock(size_t blockIndex) {
+    if (!segment->header || blockIndex >= segment->header->blockCount) {
+        segment = nullptr;
+        return;
+    }
+    const ColdBlockEntry& entry = segment->index[blockIndex];
+    block = blockIndex;
+    next = segment->base + entry.offset;
+    blockEnd = next + entry.size;
+    id = entry.firstId;
+    createdAtNs = 0;
+}
+
+bool ColdSegment::Cursor::read(ColdTask& task) {
+    while (segment && next == blockEnd) {
+        enterBlock(block + 1);
+    }
+    if (!segment) {
+        return false;
+    }
+    uint64_t gap, difference, length;
+    if (!getVarint(next, blockEnd, gap) || !getVarint(next, blockEnd, difference) || next == blockEnd) {
+        segment = nullptr;   // A corrupt block ends the segment
+        return false;
+    }
+    uint8_t flags = static_cast<uint8_t>(*next++);
+    if (!getVarint(next, blockEnd, length) || length > static_cast<uint64_t>(blockEnd - next)) {
+        segment = nullptr;
+        return false;
+    }
+    id += static_cast<int>(gap);
+    createdAtNs = static_cast<int64_t>(static_cast<uint64_t>(createdAtNs) + unzigzag(difference));
+    task.id = id;
+    task.description = std::string_view(next, static_cast<size_t>(length));
+    task.urgency = flags & 7;
+    task.createdAtNs = createdAtNs;
+    task.completed = (flags & 8) != 0;
+    next += length;
+    return true;
+}
+
+// ColdSet Implementation
+size_t ColdSet::size() const {
+    size_t total = 0;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) total += segment->size();
+    return total;
+}
+
+size_t ColdSet::completedCount() const {
+    size_t total = 0;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) total += segment->completedCount();
+    return total;
+}
+
+size_t ColdSet::levelCount(int level) const {
+    size_t total = 0;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) total += segment->levelCount(level);
+    return total;
+}
+
+size_t ColdSet::bytes() const {
+    size_t total = 0;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) total += segment->bytes();
+    return total;
+}
+
+int ColdSet::maxId() const {
+    int largest = 0;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) {
+        if (segment->size() > 0) largest = std::max(largest, segment->maxId());
+    }
+    return largest;
+}
+
+bool ColdSet::find(int id, ColdTask& task) const {
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+        if ((*it)->find(id, task)) return true;
+    }
+    return false;
+}
+
+std::vector<int> ColdSet::splitIds(size_t taskStep) const {
+    std::vector<int> ids;
+    for (const std::shared_ptr<const ColdSegment>& segment : segments) {
+        segment->splitIds(taskStep, ids);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+// ColdSet::Reader Implementation
+ColdSet::Reader::Reader(const ColdSet& set, int fromId) : firstId(fromId), started(false), lastId(0) {
+    for (const std::shared_ptr<const ColdSegment>& segment : set.segments) {
+        cursors.push_back(segment->seek(fromId));
+    }
+    heads.resize(cursors.size());
+    live.assign(cursors.size(), false);
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        advance(i);
+    }
+}
+
+void ColdSet::Reader::advance(size_t cursor) {
+    // The block a seek lands on may start before firstId
+    while ((live[cursor] = cursors[cursor].read(heads[cursor])) && heads[cursor].id < firstId) {
+    }
+}
+
+bool ColdSet::Reader::read(ColdTask& task) {
+    while (true) {
+        size_t lowest = cursors.size();
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            if (live[i] && (lowest == cursors.size() || heads[i].id < heads[lowest].id)) {
+                lowest = i;
+            }
+        }
+        if (lowest == cursors.size()) {
+            return false;
+        }
+        task = heads[lowest];
+        advance(lowest);
+        // Copies of a task in several segments come out one after the other
+        if (started && task.id == lastId) continue;
+        started = true;
+        lastId = task.id;
+        return true;
+    }
+}
+
+// ColdStorage Implementation
+bool ColdStorage::open(const std::string& path, std::string& error) {
+    if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "could not create " + path;
+        return false;
+    }
+    DIR* dir = ::opendir(path.c_str());
+    if (!dir) {
+        error = "could not read " + path;
+        return false;
+    }
+    std::vector<uint64_t> sequences;
+    while (struct dirent* entry = ::readdir(dir)) {
+        uint64_t sequence;
+        if (parseSegmentName(entry->d_name, sequence)) {
+            sequences.push_back(sequence);
+        }
+    }
+    ::closedir(dir);
+    std::sort(sequences.begin(), sequences.end());
+
+    std::vector<std::shared_ptr<const ColdSegment>> list;
+    for (uint64_t sequence : sequences) {
+        std::shared_ptr<ColdSegment> segment = std::make_shared<ColdSegment>();
+        if (!segment->open(segmentPath(path, sequence))) {
+            error = segment->error();
+            return false;
+        }
+        list.push_back(segment);
+    }
+    directory = path;
+    lastSequence = sequences.empty() ? 0 : sequences.back();
+    current = ColdSet(list);
+    return true;
+}
+
+std::string ColdStorage::nextSegmentPath() {
+    return segmentPath(directory, ++lastSequence);
+}
+
+void ColdStorage::add(std::shared_ptr<const ColdSegment> segment) {
+    std::vector<std::shared_ptr<const ColdSegment>> list = current.list();
+    list.push_back(std::move(segment));
+    current = ColdSet(list);
+}
+
+std::vector<std::shared_ptr<const ColdSegment>> ColdStorage::mergeCandidates() const {
+    std::vector<std::shared_ptr<const ColdSegment>> candidates;
+    if (current.list().size() <= kColdMaxSegments) {
+        return candidates;
+    }
+    // Merging the small half keeps the segment sizes roughly geometric
+    candidates = current.list();
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::shared_ptr<const ColdSegment>& a, const std::shared_ptr<const ColdSegment>& b) {
+                         return a->size() < b->size();
+                     });
+    candidates.resize(candidates.size() / 2);
+    return candidates;
+}
+
+void ColdStorage::replace(const std::vector<std::shared_ptr<const ColdSegment>>& merged,
+                          std::shared_ptr<const ColdSegment> replacement) {
+    std::vector<std::shared_ptr<const ColdSegment>> list;
+    for (const std::shared_ptr<const ColdSegment>& segment : current.list()) {
+        if (std::find(merged.begin(), merged.end(), segment) == merged.end()) {
+            list.push_back(segment);
+        }
+    }
+    list.push_back(std::move(replacement));
+    current = ColdSet(list);
+    // Readers holding a copy of the old set keep the files mapped
+    for (const std::shared_ptr<const ColdSegment>& segment : merged) {
+        ::unlink(segment->fileName().c_str());
+    }
+}
+
+bool mergeColdSegments(const std::string& filename, const ColdSet& sources) {
+    for (const std::shared_ptr<const ColdSegment>& segment : sources.list()) {
+        if (!segment->verify()) return false;
+    }
+    ColdSegmentWriter writer(filename, sources.size());
+    ColdSet::Reader reader(sources, std::numeric_limits<int>::min());
+    for (ColdTask task; reader.read(task);) {
+        writer.add(task.id, task.description, task.urgency, task.createdAtNs, task.completed);
+    }
+    return writer.finish();
+}
@@ -0,0 +1,478 @@
+#ifndef TODO_COLDSTORE_H
+#define TODO_COLDSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief On-disk header of a cold segment
+ *
+ * A segment file is laid out as the header, followed by blocks of up to
+ * kColdBlockTasks tasks in ascending ID order, followed by the sparse
+ * index (one ColdBlockEntry per block) and a bloom filter over every ID.
+ * Inside a block each task is encoded relative to the one before it: the
+ * ID gap and the zigzag creation time difference as varints, one byte
+ * holding the urgency level and, in bit 3, the completion state, and the
+ * description as a varint length followed by its bytes. Descriptions are
+ * stored as they are, so readers can point into the mapped file. The
+ * header, index and filter are in host byte order, checked through
+ * byteOrder as for snapshots.
+ */
+struct ColdSegmentHeader {
+    char magic[8];              ///< Always "TODOCOLD"
+    uint32_t version;           ///< Format version (currently 1)
+    uint32_t byteOrder;         ///< kSnapshotByteOrder as written by the producer
+    uint64_t taskCount;         ///< Number of tasks
+    uint64_t completedCount;    ///< Of those, completed tasks
+    uint64_t levelCounts[4];    ///< Tasks per urgency level, LOW first
+    uint64_t blockCount;        ///< Number of blocks and index entries
+    uint64_t indexOffset;       ///< File offset of the sparse index
+    uint64_t bloomOffset;       ///< File offset of the bloom filter
+    uint64_t bloomWords;        ///< Size of the bloom filter in 64-bit words
+    int64_t minCreatedAtNs;     ///< Earliest creation time, nanoseconds since the Unix epoch
+    int64_t maxCreatedAtNs;     ///< Latest creation time
+    int32_t minId;              ///< Smallest task ID
+    int32_t maxId;              ///< Largest task ID
+    uint32_t bloomHashes;       ///< Bits set per ID in the bloom filter
+    uint32_t indexChecksum;     ///< CRC-32 of the index and the bloom filter
+};
+
+/**
+ * @brief Sparse index entry of one block of a cold segment
+ */
+struct ColdBlockEntry {
+    int32_t firstId;       ///< ID of the first task in the block
+    int32_t lastId;        ///< ID of the last task in the block
+    uint64_t offset;       ///< File offset of the block
+    uint32_t size;         ///< Size of the block in bytes
+    uint32_t checksum;     ///< CRC-32 of the block
+};
+
+static_assert(sizeof(ColdSegmentHeader) == 128, "ColdSegmentHeader layout must stay fixed");
+static_assert(sizeof(ColdBlockEntry) == 24, "ColdBlockEntry layout must stay fixed");
+
+const uint32_t kColdSegmentVersion = 1;   ///< Current cold segment format version
+const size_t kColdBlockTasks = 128;       ///< Tasks per block
+const size_t kColdMaxSegments = 8;        ///< Segments a ColdStorage holds before it merges some
+
+/**
+ * @brief One task read from a cold segment
+ */
+struct ColdTask {
+    int id;                         ///< Task identifier
+    std::string_view description;   ///< View into the mapped segment
+    uint8_t urgency;                ///< Urgency level (1-4)
+    int64_t createdAtNs;            ///< Creation time in nanoseconds since the Unix epoch
+    bool completed;                 ///< Completion status
+};
+
+/**
+ * @brief Streaming writer for cold segments
+ *
+ * Tasks must be added in ascending ID order. Blocks are written as they
+ * fill up; the index and bloom filter, which are small, are kept in
+ * memory until finish(). Like SnapshotWriter it writes a temporary file
+ * that is fsynced and renamed over the target only when finish()
+ * succeeds.
+ */
+class ColdSegmentWriter {
+private:
+    std::string targetName;               ///< Final segment file name
+    std::string tempName;                 ///< Temporary file name used while writing
+    int fd;                               ///< Descriptor of the temporary file
+    bool failed;                          ///< Set once any write has failed
+    ColdSegmentHeader header;             ///< Header written by finish()
+    std::vector<ColdBlockEntry> index;    ///< Entries of the blocks written so far
+    std::vector<uint64_t> bloom;          ///< Bloom filter bits
+    std::string block;                    ///< Encoded tasks of the current block
+    std::string output;                   ///< Blocks waiting to be written
+    uint64_t fileOffset;                  ///< File offset of the first byte of output
+    size_t blockTasks;                    ///< Tasks in the current block
+    int lastId;                           ///< ID of the last task added
+    int64_t lastCreatedAtNs;              ///< Creation time of the last task added
+
+    /**
+     * @brief Close the current block and add its index entry
+     */
+    void finishBlock();
+
+    /**
+     * @brief Write the pending output at the end of the file
+     */
+    void flushOutput();
+
+public:
+    /**
+     * @brief Constructor for ColdSegmentWriter
+     * @param filename Name of the segment file to produce
+     * @param expectedTasks About how many tasks will be added, which sizes the bloom filter
+     */
+    ColdSegmentWriter(const std::string& filename, size_t expectedTasks);
+
+    /**
+     * @brief Destructor for ColdSegmentWriter
+     *
+     * Removes the temporary file if finish() was not called successfully.
+     */
+    ~ColdSegmentWriter();
+
+    ColdSegmentWriter(const ColdSegmentWriter&) = delete;
+    ColdSegmentWriter& operator=(const ColdSegmentWriter&) = delete;
+
+    /**
+     * @brief Append one task to the segment
+     * @param id Task identifier, greater than the last one added
+     * @param description Description bytes
+     * @param urgency Urgency level (1-4)
+     * @param createdAtNs Creation time in nanoseconds since the Unix epoch
+     * @param completed Completion status
+     */
+    void add(int id, std::string_view description, uint8_t urgency, int64_t createdAtNs, bool completed);
+
+    /**
+     * @brief Complete the segment and publish it under its final name
+     * @return true if every write, the fsync and the rename succeeded
+     */
+    bool finish();
+};
+
+/**
+ * @brief Read-only, memory-mapped cold segment
+ *
+ * Opening a segment maps the file and validates the header, the index
+ * and the bloom filter. A lookup rejects most absent IDs through the ID
+ * range and the bloom filter, finds the block through a binary search of
+ * the sparse index and decodes only that block.
+ */
+class ColdSegment {
+private:
+    std::string path;                    ///< Name of the mapped file
+    const char* base;                    ///< Start of the mapping
+    size_t mappedSize;                   ///< Size of the mapping
+    const ColdSegmentHeader* header;     ///< Header inside the mapping
+    const ColdBlockEntry* index;         ///< Sparse index inside the mapping
+    const uint64_t* bloom;               ///< Bloom filter inside the mapping
+    std::string errorMessage;            ///< Reason the last open() failed
+
+    /**
+     * @brief Unmap the current file, if any
+     */
+    void close();
+
+public:
+    /**
+     * @brief Position in a segment that moves forward one task at a time
+     */
+    class Cursor {
+    private:
+        const ColdSegment* segment;   ///< Segment being read, null once at the end
+        size_t block;                 ///< Block being decoded
+        const char* next;             ///< Next encoded byte of the block
+        const char* blockEnd;         ///< End of the block
+        int id;                       ///< ID of the task read last
+        int64_t createdAtNs;          ///< Creation time of the task read last
+
+        void enterBlock(size_t blockIndex);
+
+    public:
+        Cursor() : segment(nullptr), block(0), next(nullptr), blockEnd(nullptr), id(0), createdAtNs(0) {}
+
+        /**
+         * @brief Start at a block of a segment
+         * @param owner Segment to read
+         * @param blockIndex First block to decode
+         */
+        Cursor(const ColdSegment& owner, size_t blockIndex);
+
+        /**
+         * @brief Read the next task
+         * @param task Receives the task
+         * @return false at the end of the segment
+         */
+        bool read(ColdTask& task);
+    };
+
+    /**
+     * @brief Constructor for ColdSegment
+     *
+     * Creates an empty segment; call open() to map a file.
+     */
+    ColdSegment();
+
+    /**
+     * @brief Destructor for ColdSegment
+     *
+     * Unmaps the file. Views of its descriptions become invalid.
+     */
+    ~ColdSegment();
+
+    ColdSegment(const ColdSegment&) = delete;
+    ColdSegment& operator=(const ColdSegment&) = delete;
+
+    /**
+     * @brief Map and validate a segment file
+     * @param filename Name of the segment file
+     * @return true if the file is a valid segment, false otherwise
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Check every block against its checksum
+     * @return true if no block is corrupt
+     *
+     * open() only checks the index, so that opening does not read every
+     * block; merging calls this before it rewrites the tasks.
+     */
+    bool verify() const;
+
+    /**
+     * @brief Get the reason the last open() failed
+     * @return Human-readable error description
+     */
+    const std::string& error() const { return errorMessage; }
+
+    /**
+     * @brief Get the name of the mapped file
+     * @return File name passed to open()
+     */
+    const std::string& fileName() const { return path; }
+
+    /**
+     * @brief Get the number of tasks in the segment
+     * @return Task count
+     */
+    size_t size() const { return header ? static_cast<size_t>(header->taskCount) : 0; }
+
+    /**
+     * @brief Get the number of completed tasks in the segment
+     * @return Completed task count
+     */
+    size_t completedCount() const { return header ? static_cast<size_t>(header->completedCount) : 0; }
+
+    /**
+     * @brief Get the number of tasks of an urgency level
+     * @param level Urgency level (1-4)
+     * @return Task count
+     */
+    size_t levelCount(int level) const { return header ? static_cast<size_t>(header->levelCounts[level - 1]) : 0; }
+
+    int minId() const { return header ? header->minId : 0; }                         ///< Smallest task ID
+    int maxId() const { return header ? header->maxId : 0; }                         ///< Largest task ID
+    int64_t minCreatedAtNs() const { return header ? header->minCreatedAtNs : 0; }   ///< Earliest creation time
+    int64_t maxCreatedAtNs() const { return header ? header->maxCreatedAtNs : 0; }   ///< Latest creation time
+
+    /**
+     * @brief Get the size of the file
+     * @return Bytes mapped
+     */
+    size_t bytes() const { return mappedSize; }
+
+    /**
+     * @brief Check the ID range and the bloom filter
+     * @param id Task ID
+     * @return false if the segment certainly does not hold the ID
+     */
+    bool mayContain(int id) const;
+
+    /**
+     * @brief Look up a task
+     * @param id Task ID
+     * @param task Receives the task if found
+     * @return true if the segment holds the ID
+     */
+    bool find(int id, ColdTask& task) const;
+
+    /**
+     * @brief Get a cursor at the first block that may hold an ID or a larger one
+     * @param firstId Smallest ID of interest; tasks before it may still be read
+     * @return Cursor to read from
+     */
+    Cursor seek(int firstId) const;
+
+    /**
+     * @brief Append the first IDs of evenly spaced blocks
+     * @param taskStep About how many tasks to leave between two IDs
+     * @param ids Receives the IDs, ascending
+     */
+    void splitIds(size_t taskStep, std::vector<int>& ids) const;
+};
+
+/**
+ * @brief Immutable set of cold segments read as one sorted list of tasks
+ *
+ * Segments may overlap in their ID ranges, and after a crash in the
+ * middle of moving or merging tasks two segments may hold the same task;
+ * the merged reads list such a task once. Copying a set shares the
+ * segments, which stay mapped for as long as any copy uses them.
+ */
+class ColdSet {
+private:
+    std::vector<std::shared_ptr<const ColdSegment>> segments;   ///< Oldest first
+
+public:
+    /**
+     * @brief Reads the tasks of every segment in ascending ID order
+     */
+    class Reader {
+    private:
+        std::vector<ColdSegment::Cursor> cursors;   ///< One per segment
+        std::vector<ColdTask> heads;                ///< Next task of each cursor
+        std::vector<bool> live;                     ///< Whether a cursor has a head
+        int firstId;                                ///< Tasks before this ID are skipped
+        bool started;                               ///< Whether any task was returned
+        int lastId;                                 ///< ID of the task returned last
+
+        /**
+         * @brief Move a cursor to its next task at or after firstId
+         * @param cursor Index of the cursor
+         */
+        void advance(size_t cursor);
+
+    public:
+        /**
+         * @brief Start reading a set
+         * @param set Set to read; must outlive the reader
+         * @param fromId Smallest ID to return
+         */
+        Reader(const ColdSet& set, int fromId);
+
+        /**
+         * @brief Read the next task
+         * @param task Receives the task with the smallest ID not returned yet
+         * @return false once every task was returned
+         */
+        bool read(ColdTask& task);
+    };
+
+    ColdSet() = default;
+
+    /**
+     * @brief Build a set from segments
+     * @param list Segments, oldest first
+     */
+    explicit ColdSet(std::vector<std::shared_ptr<const ColdSegment>> list) : segments(std::move(list)) {}
+
+    /**
+     * @brief Get the segments
+     * @return Segments, oldest first
+     */
+    const std::vector<std::shared_ptr<const ColdSegment>>& list() const { return segments; }
+
+    bool empty() const { return segments.empty(); }   ///< Whether the set holds no segment
+    size_t size() const;                              ///< Tasks in every segment, see completedCount()
+    size_t completedCount() const;                    ///< Completed tasks in every segment
+    size_t levelCount(int level) const;               ///< Tasks of an urgency level (1-4)
+    size_t bytes() const;                             ///< Size of every segment file
+    int maxId() const;                                ///< Largest ID, 0 for an empty set
+
+    /**
+     * @brief Look up a task
+     * @param id Task ID
+     * @param task Receives the task if found
+     * @return true if some segment holds the ID
+     */
+    bool find(int id, ColdTask& task) const;
+
+    /**
+     * @brief Keep only some segments
+     * @param keep Returns whether a segment is kept
+     * @return Set of the kept segments
+     *
+     * Lets a reader skip segments whose ID or creation time range cannot
+     * match before reading any block.
+     */
+    template <typename Pred>
+    ColdSet select(Pred keep) const {
+        std::vector<std::shared_ptr<const ColdSegment>> kept;
+        for (const std::shared_ptr<const ColdSegment>& segment : segments) {
+            if (keep(*segment)) kept.push_back(segment);
+        }
+        return ColdSet(kept);
+    }
+
+    /**
+     * @brief Get IDs that split the set into runs of about the same size
+     * @param taskStep About how many tasks each segment contributes to a run
+     * @return Ascending, distinct IDs
+     */
+    std::vector<int> splitIds(size_t taskStep) const;
+};
+
+/**
+ * @brief Directory of cold segments with the set currently in use
+ *
+ * Segments are named cold-<sequence>.seg and never change once written.
+ * Adding a segment and replacing merged ones only swaps the current
+ * ColdSet; files are deleted after the swap, while readers that copied
+ * the old set keep their mappings. Not thread-safe: TodoApp publishes
+ * changes under its exclusive lock and writes segments one at a time.
+ */
+class ColdStorage {
+private:
+    std::string directory;   ///< Directory holding the segments
+    uint64_t lastSequence;   ///< Highest segment sequence in use
+    ColdSet current;         ///< Segments in use, oldest first
+
+public:
+    ColdStorage() : lastSequence(0) {}
+
+    /**
+     * @brief Create the directory if needed and open every segment in it
+     * @param path Directory of the cold segments
+     * @param error Receives the reason when opening fails
+     * @return true if the directory and every segment could be opened
+     */
+    bool open(const std::string& path, std::string& error);
+
+    /**
+     * @brief Get the segments in use
+     * @return Current set
+     */
+    const ColdSet& segments() const { return current; }
+
+    /**
+     * @brief Get the directory of the segments
+     * @return Path passed to open()
+     */
+    const std::string& path() const { return directory; }
+
+    /**
+     * @brief Reserve the file name of the next segment
+     * @return Full path, which no segment uses yet
+     */
+    std::string nextSegmentPath();
+
+    /**
+     * @brief Start using a new segment
+     * @param segment Opened segment
+     */
+    void add(std::shared_ptr<const ColdSegment> segment);
+
+    /**
+     * @brief Choose segments to merge once there are too many
+     * @return The smaller half of the segments, empty while at most kColdMaxSegments are in use
+     */
+    std::vector<std::shared_ptr<const ColdSegment>> mergeCandidates() const;
+
+    /**
+     * @brief Replace merged segments by the segment they were merged into
+     * @param merged Segments returned by mergeCandidates()
+     * @param replacement Opened segment holding their tasks
+     */
+    void replace(const std::vector<std::shared_ptr<const ColdSegment>>& merged,
+                 std::shared_ptr<const ColdSegment> replacement);
+};
+
+/**
+ * @brief Write the tasks of several segments into one
+ * @param filename Name of the segment file to produce
+ * @param sources Segments to merge
+ * @return true if every source is intact and the new segment was written
+ */
+bool mergeColdSegments(const std::string& filename, const ColdSet& sources);
+
+#endif // TODO_COLDSTORE_H
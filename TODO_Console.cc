@@ -0,0 +1,122 @@
+#include "TODO_Console.h"
+#include "TODO_App.h"
+#include <iostream>
+
+namespace {
+
+struct ColumnSpec {
+    TaskColumn column;
+    std::string_view heading;
+    size_t width;
+};
+
+const ColumnSpec kColumns[] = {
+    {COLUMN_ID, "ID", 5},
+    {COLUMN_DESCRIPTION, "Description", 40},
+    {COLUMN_URGENCY, "Urgency", 12},
+    {COLUMN_CREATED, "Created", 20},
+    {COLUMN_STATUS, "Status", 10},
+};
+
+const size_t kDescriptionBytes = 39;   // Description bytes shown, leaving one space
+
+// Pad a cell that started at offset to its column width
+void padCell(OutputBuffer& out, size_t start, size_t width) {
+    size_t used = out.size() - start;
+    if (used < width) out.appendRepeated(' ', width - used);
+}
+
+} // namespace
+
+// ConsoleSink Implementation
+void ConsoleSink::taskEvent(TaskEvent event, int id) {
+    switch (event) {
+        case TaskEvent::ADDED:
+            std::cout << "Task added successfully! ID: " << id << std::endl;
+            break;
+        case TaskEvent::REMOVED:
+            std::cout << "Task removed successfully!" << std::endl;
+            break;
+        case TaskEvent::COMPLETED:
+            std::cout << "Task marked as completed!" << std::endl;
+            break;
+        case TaskEvent::NOT_FOUND:
+            std::cout << "Task with ID " << id << " not found!" << std::endl;
+            break;
+        case TaskEvent::ARCHIVED:
+            std::cout << "Task with ID " << id << " is in cold storage and cannot be changed!" << std::endl;
+            break;
+    }
+}
+
+void ConsoleSink::message(MessageLevel, std::string_view text) {
+    std::cout << text << std::endl;
+}
+
+void ConsoleSink::write(std::string_view text) {
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
+}
+
+ConsoleSink& consoleSink() {
+    static ConsoleSink sink;
+    return sink;
+}
+
+NullSink& nullSink() {
+    static NullSink sink;
+    return sink;
+}
+
+// TaskTable Implementation
+TaskTable::TaskTable(std::string_view title, unsigned shownColumns)
+    : columns(shownColumns), text(4096) {
+    text.append("\n=== ").append(title).append(" ===\n");
+    size_t width = 0;
+    for (const ColumnSpec& spec : kColumns) {
+        if (!(columns & spec.column)) continue;
+        size_t start = text.size();
+        text.append(spec.heading);
+        padCell(text, start, spec.width);
+        width += spec.width;
+    }
+    text.append('\n').appendRepeated('-', width).append('\n');
+}
+
+void TaskTable::addCells(int id, std::string_view description, Urgency urgency,
+                         std::chrono::system_clock::time_point createdAt, bool completed) {
+    for (const ColumnSpec& spec : kColumns) {
+        if (!(columns & spec.column)) continue;
+        size_t start = text.size();
+        switch (spec.column) {
+            case COLUMN_ID:
+                text.appendInt(id);
+                break;
+            case COLUMN_DESCRIPTION:
+                text.append(description.substr(0, kDescriptionBytes));
+                break;
+            case COLUMN_URGENCY:
+                text.append(urgencyName(urgency));
+                break;
+            case COLUMN_CREATED:
+                text.appendTimestamp(createdAt);
+                break;
+            default:
+                text.append(completed ? "DONE" : "PENDING");
+                break;
+        }
+        padCell(text, start, spec.width);
+    }
+    text.append('\n');
+}
+
+void TaskTable::flushTo(OutputSink& sink) {
+    if (text.size() == 0) return;
+    sink.write(std::string_view(text.data(), text.size()));
+    text.clear();
+}
+
+void TaskTable::writeTo(OutputSink& sink) {
+    text.append('\n');
+    sink.write(std::string_view(text.data(), text.size()));
+}
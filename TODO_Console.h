@@ -0,0 +1,168 @@
+#ifndef TODO_CONSOLE_H
+#define TODO_CONSOLE_H
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "TODO_Output.h"
+
+enum class Urgency;
+
+/**
+ * @brief Single-task changes reported by TodoApp
+ */
+enum class TaskEvent {
+    ADDED,       ///< addTask() added the task
+    REMOVED,     ///< removeTask() removed the task
+    COMPLETED,   ///< markCompleted() completed the task
+    NOT_FOUND,   ///< removeTask() or markCompleted() found no task with the ID
+    ARCHIVED     ///< removeTask() or markCompleted() found the task in the read-only cold tier
+};
+
+/**
+ * @brief Severity of a message line
+ */
+enum class MessageLevel {
+    INFO,   ///< Outcome of an operation, e.g. "Imported 5 tasks from a.csv"
+    ERROR   ///< Failure, text starting with "Error:"
+};
+
+/**
+ * @brief Receiver of everything TodoApp reports
+ *
+ * TodoApp never writes to the console itself. Single-task changes arrive
+ * as structured events, so a sink that ignores them costs a virtual call
+ * and no formatting; other outcomes arrive as finished message lines, and
+ * the display functions hand over their whole rendered text at once.
+ * Calls can come from several threads at the same time.
+ */
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    /**
+     * @brief A single task was changed, or the task to change was missing
+     * @param event What happened
+     * @param id ID of the task
+     */
+    virtual void taskEvent(TaskEvent event, int id) = 0;
+
+    /**
+     * @brief A message for the user
+     * @param level Severity of the message
+     * @param text One line, without a line terminator
+     */
+    virtual void message(MessageLevel level, std::string_view text) = 0;
+
+    /**
+     * @brief Rendered output of a display function
+     * @param text Complete text, including line terminators
+     */
+    virtual void write(std::string_view text) = 0;
+};
+
+/**
+ * @brief Sink that prints to std::cout, the way the interactive menu expects
+ *
+ * Messages are flushed one by one, so they show up before the next
+ * prompt; rendered text goes out in one write.
+ */
+class ConsoleSink : public OutputSink {
+public:
+    void taskEvent(TaskEvent event, int id) override;
+    void message(MessageLevel level, std::string_view text) override;
+    void write(std::string_view text) override;
+};
+
+/**
+ * @brief Sink that discards everything, for library and server use
+ */
+class NullSink : public OutputSink {
+public:
+    void taskEvent(TaskEvent, int) override {}
+    void message(MessageLevel, std::string_view) override {}
+    void write(std::string_view) override {}
+};
+
+/**
+ * @brief Shared ConsoleSink, the default sink of every TodoApp
+ */
+ConsoleSink& consoleSink();
+
+/**
+ * @brief Shared NullSink
+ */
+NullSink& nullSink();
+
+/**
+ * @brief Columns a TaskTable can show, combined as a bit mask
+ */
+enum TaskColumn : unsigned {
+    COLUMN_ID = 1u << 0,            ///< Task ID, 5 wide
+    COLUMN_DESCRIPTION = 1u << 1,   ///< First 39 bytes of the description, 40 wide
+    COLUMN_URGENCY = 1u << 2,       ///< Urgency name, 12 wide
+    COLUMN_CREATED = 1u << 3,       ///< Creation time, 20 wide
+    COLUMN_STATUS = 1u << 4,        ///< DONE or PENDING, 10 wide
+    COLUMN_ALL = (1u << 5) - 1      ///< Every column
+};
+
+/**
+ * @brief Fixed-width task table rendered into one buffer
+ *
+ * The title, header row and rule are formatted once by the constructor;
+ * each row is then appended to the same buffer with padding computed from
+ * the column widths, without streams. A cell wider than its column pushes
+ * the rest of the row to the right, as std::setw would.
+ *
+ * @par Example:
+ * @code
+ * TaskTable table("ALL TASKS", COLUMN_ALL);
+ * for (const TaskRef& task : app.snapshot()) {
+ *     table.addRow(task);
+ * }
+ * table.writeTo(consoleSink());
+ * @endcode
+ */
+class TaskTable {
+private:
+    unsigned columns;     ///< TaskColumn bits shown
+    OutputBuffer text;    ///< Rendered table so far
+
+    void addCells(int id, std::string_view description, Urgency urgency,
+                  std::chrono::system_clock::time_point createdAt, bool completed);
+
+public:
+    /**
+     * @brief Start a table with its title, header row and rule
+     * @param title Title, shown as "=== title ==="
+     * @param shownColumns TaskColumn bits of the columns to show, in ID to status order
+     */
+    TaskTable(std::string_view title, unsigned shownColumns);
+
+    /**
+     * @brief Append a row
+     * @param task Task or TaskRef to show
+     */
+    template <typename TaskType>
+    void addRow(const TaskType& task) {
+        addCells(task.id, task.description, task.urgency, task.createdAt, task.completed);
+    }
+
+    /**
+     * @brief Hand the rows rendered so far to a sink and keep building
+     * @param sink Sink to write to
+     *
+     * Lets a long table reach the sink while it is produced; the next rows
+     * continue the same table without repeating the header.
+     */
+    void flushTo(OutputSink& sink);
+    
+    /**
+     * @brief Finish the table and hand the rest of it to a sink in one write
+     * @param sink Sink to write to
+     */
+    void writeTo(OutputSink& sink);
+};
+
+#endif // TODO_CONSOLE_H
@@ -0,0 +1,349 @@
+#ifndef TODO_EXPORT_H
+#define TODO_EXPORT_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+#include <utility>
+
+#include "TODO_App.h"
+#include "TODO_Output.h"
+
+/**
+ * @brief Task field written by the exporters
+ */
+enum class ExportField {
+    ID,            ///< Task ID
+    DESCRIPTION,   ///< Description text
+    URGENCY,       ///< Urgency name
+    CREATED,       ///< Creation time
+    STATUS         ///< Completion status
+};
+
+/**
+ * @brief One column of the export schema
+ */
+struct ExportColumn {
+    ExportField field;        ///< Task field written in the column
+    std::string_view label;   ///< Name in the text export and the CSV header
+    std::string_view key;     ///< Key in the JSON exports
+};
+
+/**
+ * @brief Columns of every export, in the order they are written
+ *
+ * The importers find a record by the field written last (the status in
+ * CSV, "completed" in JSON), so STATUS must stay at the end.
+ */
+constexpr ExportColumn kExportSchema[] = {
+    {ExportField::ID, "ID", "id"},
+    {ExportField::DESCRIPTION, "Description", "description"},
+    {ExportField::URGENCY, "Urgency", "urgency"},
+    {ExportField::CREATED, "Created", "created"},
+    {ExportField::STATUS, "Status", "completed"},
+};
+
+constexpr size_t kExportColumnCount = sizeof(kExportSchema) / sizeof(kExportSchema[0]);
+
+static_assert(kExportSchema[kExportColumnCount - 1].field == ExportField::STATUS,
+              "The importers expect the status last");
+
+/**
+ * @brief Short text assembled at compile time, such as a column's label and separator
+ */
+struct ExportLiteral {
+    char text[48];   ///< Joined bytes
+    size_t length;   ///< Number of bytes used
+
+    constexpr std::string_view view() const { return std::string_view(text, length); }
+};
+
+/**
+ * @brief Join pieces of text at compile time
+ * @param parts Pieces, 48 bytes in total at most
+ * @return Joined text
+ */
+constexpr ExportLiteral joinLiteral(std::initializer_list<std::string_view> parts) {
+    ExportLiteral joined{};
+    for (std::string_view part : parts) {
+        for (char c : part) {
+            joined.text[joined.length++] = c;
+        }
+    }
+    return joined;
+}
+
+/**
+ * @brief Append text as the body of a JSON string
+ * @param out Buffer to append to
+ * @param text Bytes to escape
+ *
+ * Quotes, backslashes and control characters are escaped; everything
+ * else, UTF-8 included, is copied in runs between them.
+ */
+inline void appendJsonEscaped(OutputBuffer& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+}
+
+/**
+ * @brief Append text as a quoted CSV field
+ * @param out Buffer to append to
+ * @param text Field contents
+ *
+ * Quotes inside the text are doubled, as RFC 4180 and importFromFile()
+ * expect; commas and line breaks need no escaping inside the quotes.
+ */
+inline void appendCsvQuoted(OutputBuffer& out, std::string_view text) {
+    out.append('"');
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '"') continue;
+        out.append(text.data() + runStart, i + 1 - runStart);
+        out.append('"');
+        runStart = i + 1;
+    }
+    out.append(text.data() + runStart, text.size() - runStart).append('"');
+}
+
+/**
+ * @brief Helper to append a field as plain text, as the text and CSV exports write it
+ * @param out Buffer to append to
+ * @param task Task to read the field from
+ *
+ * The description is copied as is; callers that need escaping handle it
+ * before calling this.
+ */
+template <ExportField Field, TimestampFormat Times>
+void appendPlainField(OutputBuffer& out, const TaskRef& task) {
+    if constexpr (Field == ExportField::ID) {
+        out.appendInt(task.id);
+    } else if constexpr (Field == ExportField::DESCRIPTION) {
+        out.append(task.description);
+    } else if constexpr (Field == ExportField::URGENCY) {
+        out.append(urgencyName(task.urgency));
+    } else if constexpr (Field == ExportField::CREATED) {
+        out.appendTimestamp(task.createdAt, Times);
+    } else {
+        out.append(task.completed ? "COMPLETED" : "PENDING");
+    }
+}
+
+/**
+ * @brief Helper to append a field as a JSON value
+ * @param out Buffer to append to
+ * @param task Task to read the field from
+ *
+ * Epoch times are written as numbers, local times as strings, and the
+ * status as a boolean.
+ */
+template <ExportField Field, TimestampFormat Times>
+void appendJsonField(OutputBuffer& out, const TaskRef& task) {
+    if constexpr (Field == ExportField::ID) {
+        out.appendInt(task.id);
+    } else if constexpr (Field == ExportField::DESCRIPTION) {
+        out.append('"');
+        appendJsonEscaped(out, task.description);
+        out.append('"');
+    } else if constexpr (Field == ExportField::URGENCY) {
+        out.append('"').append(urgencyName(task.urgency)).append('"');
+    } else if constexpr (Field == ExportField::CREATED) {
+        if constexpr (Times == TimestampFormat::EPOCH) {
+            out.appendTimestamp(task.createdAt, Times);
+        } else {
+            out.append('"').appendTimestamp(task.createdAt, Times).append('"');
+        }
+    } else {
+        out.append(task.completed ? "true" : "false");
+    }
+}
+
+/**
+ * @brief Human-readable text export: one "Label: value" line per field
+ */
+template <TimestampFormat Times>
+struct TextExport {
+    static constexpr std::string_view kName = "file";   ///< Format name for messages
+    static constexpr size_t kTrimFirst = 0;             ///< Bytes dropped before the first record
+
+    /// Text written before the value of a column
+    template <size_t Column>
+    static constexpr ExportLiteral kPrefix = joinLiteral({kExportSchema[Column].label, ": "});
+
+    static void appendHeader(OutputBuffer& out) {
+        out.append("TODO APP EXPORT - ").appendTimestamp(std::chrono::system_clock::now(), Times).append('\n');
+        out.appendRepeated('=', 50).append('\n');
+    }
+    static void appendFooter(OutputBuffer&, bool) {}
+
+    static void beginRecord(OutputBuffer&) {}
+    template <size_t Column>
+    static void appendColumn(OutputBuffer& out, const TaskRef& task) {
+        constexpr std::string_view prefix = kPrefix<Column>.view();
+        out.append(prefix);
+        appendPlainField<kExportSchema[Column].field, Times>(out, task);
+        out.append('\n');
+    }
+    static void endRecord(OutputBuffer& out) {
+        out.appendRepeated('-', 30).append('\n');
+    }
+};
+
+/**
+ * @brief CSV export with a header row and a quoted description
+ */
+template <TimestampFormat Times>
+struct CsvExport {
+    static constexpr std::string_view kName = "CSV";
+    static constexpr size_t kTrimFirst = 0;
+
+    static void appendHeader(OutputBuffer& out) {
+        for (size_t column = 0; column < kExportColumnCount; ++column) {
+            if (column > 0) out.append(',');
+            out.append(kExportSchema[column].label);
+        }
+        out.append('\n');
+    }
+    static void appendFooter(OutputBuffer&, bool) {}
+
+    static void beginRecord(OutputBuffer&) {}
+    template <size_t Column>
+    static void appendColumn(OutputBuffer& out, const TaskRef& task) {
+        if constexpr (Column > 0) {
+            out.append(',');
+        }
+        if constexpr (kExportSchema[Column].field == ExportField::DESCRIPTION) {
+            appendCsvQuoted(out, task.description);
+        } else {
+            appendPlainField<kExportSchema[Column].field, Times>(out, task);
+        }
+    }
+    static void endRecord(OutputBuffer& out) {
+        out.append('\n');
+    }
+};
+
+/**
+ * @brief Indented JSON document with a "tasks" array and the export time
+ *
+ * Every object is preceded by the separator, which is trimmed off the
+ * first one wherever it lands.
+ */
+template <TimestampFormat Times>
+struct JsonExport {
+    static constexpr std::string_view kName = "JSON";
+    static constexpr std::string_view kSeparator = ",\n";
+    static constexpr size_t kTrimFirst = kSeparator.size();
+
+    template <size_t Column>
+    static constexpr ExportLiteral kPrefix =
+        joinLiteral({Column > 0 ? ",\n" : "", "      \"", kExportSchema[Column].key, "\": "});
+
+    static void appendHeader(OutputBuffer& out) {
+        out.append("{\n  \"tasks\": [\n");
+    }
+    static void appendFooter(OutputBuffer& out, bool anyTasks) {
+        if (anyTasks) {
+            out.append('\n');
+        }
+        out.append("  ],\n  \"exported_at\": ");
+        if constexpr (Times == TimestampFormat::EPOCH) {
+            out.appendTimestamp(std::chrono::system_clock::now(), Times);
+        } else {
+            out.append('"').appendTimestamp(std::chrono::system_clock::now(), Times).append('"');
+        }
+        out.append("\n}\n");
+    }
+
+    static void beginRecord(OutputBuffer& out) {
+        out.append(kSeparator).append("    {\n");
+    }
+    template <size_t Column>
+    static void appendColumn(OutputBuffer& out, const TaskRef& task) {
+        constexpr std::string_view prefix = kPrefix<Column>.view();
+        out.append(prefix);
+        appendJsonField<kExportSchema[Column].field, Times>(out, task);
+    }
+    static void endRecord(OutputBuffer& out) {
+        out.append("\n    }");
+    }
+};
+
+/**
+ * @brief Newline-delimited JSON: one compact object per line, no wrapper
+ *
+ * Suits tools that stream records, such as jq or log shippers, and is
+ * read back by importFromFile() like a JSON export.
+ */
+template <TimestampFormat Times>
+struct NdjsonExport {
+    static constexpr std::string_view kName = "NDJSON";
+    static constexpr size_t kTrimFirst = 0;
+
+    template <size_t Column>
+    static constexpr ExportLiteral kPrefix =
+        joinLiteral({Column > 0 ? "," : "", "\"", kExportSchema[Column].key, "\":"});
+
+    static void appendHeader(OutputBuffer&) {}
+    static void appendFooter(OutputBuffer&, bool) {}
+
+    static void beginRecord(OutputBuffer& out) {
+        out.append('{');
+    }
+    template <size_t Column>
+    static void appendColumn(OutputBuffer& out, const TaskRef& task) {
+        constexpr std::string_view prefix = kPrefix<Column>.view();
+        out.append(prefix);
+        appendJsonField<kExportSchema[Column].field, Times>(out, task);
+    }
+    static void endRecord(OutputBuffer& out) {
+        out.append("}\n", 2);
+    }
+};
+
+/**
+ * @brief Helper to append every column of a record
+ */
+template <typename Format, size_t... Columns>
+void appendExportColumns(OutputBuffer& out, const TaskRef& task, std::index_sequence<Columns...>) {
+    (Format::template appendColumn<Columns>(out, task), ...);
+}
+
+/**
+ * @brief Append one task in an export format
+ * @param out Buffer to append to
+ * @param task Task to write
+ *
+ * The format and the schema are both known at compile time, so the
+ * columns unroll into straight-line appends with no per-row branching
+ * on the format or the timestamp style.
+ */
+template <typename Format>
+void appendExportRecord(OutputBuffer& out, const TaskRef& task) {
+    Format::beginRecord(out);
+    appendExportColumns<Format>(out, task, std::make_index_sequence<kExportColumnCount>());
+    Format::endRecord(out);
+}
+
+#endif // TODO_EXPORT_H
@@ -0,0 +1,493 @@
+#include "TODO_Headless.h"
+#include "TODO_Query.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const size_t kReadBytes = 64 * 1024;          ///< Bytes requested per read()
+const size_t kMaxLineBytes = 1 << 20;         ///< Longest request line accepted
+const size_t kReplyFlushBytes = 1 << 20;      ///< Reply size written before a request ends
+
+/**
+ * @brief Split off the first space-separated word
+ * @param text Text to read from, advanced past the word and the spaces after it
+ * @return The word, empty at the end of the text
+ */
+std::string_view nextWord(std::string_view& text) {
+    size_t start = text.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        text = std::string_view();
+        return text;
+    }
+    size_t end = text.find(' ', start);
+    std::string_view word = text.substr(start, end == std::string_view::npos ? end : end - start);
+    size_t rest = end == std::string_view::npos ? text.size() : text.find_first_not_of(' ', end);
+    text = rest == std::string_view::npos ? std::string_view() : text.substr(rest);
+    return word;
+}
+
+/**
+ * @brief Compare a word to an upper-case keyword, ignoring ASCII case
+ */
+bool isKeyword(std::string_view word, std::string_view keyword) {
+    if (word.size() != keyword.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < word.size(); ++i) {
+        char c = word[i];
+        if ((c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c) != keyword[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Number>
+bool parseNumber(std::string_view text, Number& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+/**
+ * @brief Parse an urgency name or level number
+ * @param word "low", "medium", "high", "critical" in any case, or 1-4
+ * @param urgency Receives the urgency
+ * @return false if the word names no urgency
+ */
+bool parseUrgency(std::string_view word, Urgency& urgency) {
+    static const std::string_view names[] = {"LOW", "MEDIUM", "HIGH", "CRITICAL"};
+    int level;
+    if (parseNumber(word, level) && level >= 1 && level <= 4) {
+        urgency = intToUrgency(level);
+        return true;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (isKeyword(word, names[i])) {
+            urgency = intToUrgency(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Append text with backslash, tab, newline and carriage return escaped
+ */
+void appendEscaped(OutputBuffer& out, std::string_view text) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char escape;
+        switch (text[i]) {
+            case '\\': escape = '\\'; break;
+            case '\t': escape = 't'; break;
+            case '\n': escape = 'n'; break;
+            case '\r': escape = 'r'; break;
+            default: continue;
+        }
+        out.append(text.data() + start, i - start).append('\\').append(escape);
+        start = i + 1;
+    }
+    out.append(text.data() + start, text.size() - start);
+}
+
+} // namespace
+
+// CommandSession Implementation
+CommandSession::CommandSession(TodoApp& todoApp, int inputFd, int outputFd,
+                               std::function<void()> shutdown)
+    : app(todoApp), input(inputFd), output(outputFd), onShutdown(std::move(shutdown)),
+      replies(kReadBytes), writeFailed(false), finished(false), runKind(RunKind::NONE) {}
+
+bool CommandSession::run() {
+    std::string pending;
+    bool readFailed = false;
+    while (!finished) {
+        size_t used = pending.size();
+        pending.resize(used + kReadBytes);
+        ssize_t count = read(input, &pending[used], kReadBytes);
+        if (count <= 0) {
+            pending.resize(used);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            readFailed = count < 0;
+            break;
+        }
+        pending.resize(used + static_cast<size_t>(count));
+
+        // Handle every complete line, then answer them with one write
+        size_t start = 0;
+        for (size_t end; !finished && (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+            std::string_view line(pending.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            handleLine(line);
+        }
+        pending.erase(0, start);
+        if (!finished && pending.size() > kMaxLineBytes) {
+            flushRun();
+            replies.append("ERR line too long\n");
+            finished = true;
+        }
+        flushRun();
+        writeReplies();
+    }
+
+    // A last request without a line terminator still counts
+    if (!finished && !readFailed && !pending.empty()) {
+        handleLine(pending);
+    }
+    flushRun();
+    writeReplies();
+    return !readFailed && !writeFailed;
+}
+
+void CommandSession::handleLine(std::string_view line) {
+    std::string_view rest = line;
+    std::string_view verb = nextWord(rest);
+    if (verb.empty()) {
+        return;
+    }
+
+    // Mutations join the run of their kind; anything else ends the run first
+    if (isKeyword(verb, "ADD")) {
+        Urgency urgency;
+        std::string_view level = nextWord(rest);
+        while (!rest.empty() && rest.back() == ' ') rest.remove_suffix(1);
+        if (!parseUrgency(level, urgency) || rest.empty()) {
+            flushRun();
+            replies.append(rest.empty() ? "ERR usage: ADD urgency description\n" : "ERR invalid urgency\n");
+            return;
+        }
+        if (runKind != RunKind::ADD) flushRun();
+        runKind = RunKind::ADD;
+        runTasks.push_back(NewTask{std::string(rest), urgency});
+        return;
+    }
+    bool done = isKeyword(verb, "DONE");
+    if (done || isKeyword(verb, "REMOVE")) {
+        int id;
+        if (!parseNumber(nextWord(rest), id) || !rest.empty()) {
+            flushRun();
+            replies.append("ERR invalid task ID\n");
+            return;
+        }
+        RunKind kind = done ? RunKind::DONE : RunKind::REMOVE;
+        if (runKind != kind) flushRun();
+        runKind = kind;
+        runIds.push_back(id);
+        return;
+    }
+    flushRun();
+
+    if (isKeyword(verb, "GET")) {
+        int id;
+        if (!parseNumber(nextWord(rest), id) || !rest.empty()) {
+            replies.append("ERR invalid task ID\n");
+            return;
+        }
+        std::vector<Task> tasks = app.runQuery(TaskQuery().idsBetween(id, id));
+        if (tasks.empty()) {
+            replies.append("ERR task not found\n");
+            return;
+        }
+        appendTask(tasks[0]);
+        replies.append("END 1\n");
+    } else if (isKeyword(verb, "LIST")) {
+        handleList(rest);
+    } else if (isKeyword(verb, "SEARCH")) {
+        size_t count = 0;
+        for (const Task& task : app.searchTasks(std::string(rest))) {
+            appendTask(task);
+            count++;
+        }
+        replies.append("END ").appendInt(static_cast<int64_t>(count)).append('\n');
+    } else if (isKeyword(verb, "CLEAR")) {
+        app.clearCompleted();
+        replies.append("OK\n");
+    } else if (isKeyword(verb, "STATS")) {
+        replies.append("OK total=").appendInt(app.getTotalTasks())
+               .append(" pending=").appendInt(app.getPendingTasksCount())
+               .append(" completed=").appendInt(app.getCompletedTasksCount()).append('\n');
+    } else if (isKeyword(verb, "METRICS")) {
+        size_t start = replies.size();
+        appendPrometheus(replies, app.metrics());
+        size_t lines = static_cast<size_t>(std::count(replies.data() + start, replies.data() + replies.size(), '\n'));
+        replies.append("END ").appendInt(static_cast<int64_t>(lines)).append('\n');
+    } else if (isKeyword(verb, "EXPORT")) {
+        std::string_view format = nextWord(rest);
+        // "epoch" before the file name selects epoch-second timestamps
+        TimestampFormat times = TimestampFormat::LOCAL;
+        std::string_view afterOption = rest;
+        if (isKeyword(nextWord(afterOption), "EPOCH") && !afterOption.empty()) {
+            times = TimestampFormat::EPOCH;
+            rest = afterOption;
+        }
+        std::string filename(rest);
+        bool saved;
+        if (filename.empty()) {
+            replies.append("ERR usage: EXPORT txt|csv|json|ndjson|snap [epoch] file\n");
+            return;
+        } else if (isKeyword(format, "TXT")) {
+            saved = app.exportToFile(filename, times);
+        } else if (isKeyword(format, "CSV")) {
+            saved = app.exportToCSV(filename, times);
+        } else if (isKeyword(format, "JSON")) {
+            saved = app.exportToJSON(filename, times);
+        } else if (isKeyword(format, "NDJSON")) {
+            saved = app.exportToNDJSON(filename, times);
+        } else if (isKeyword(format, "SNAP")) {
+            saved = app.saveSnapshot(filename);
+        } else {
+            replies.append("ERR unknown export format\n");
+            return;
+        }
+        replies.append(saved ? "OK\n" : "ERR could not write file\n");
+    } else if (isKeyword(verb, "IMPORT")) {
+        if (rest.empty()) {
+            replies.append("ERR usage: IMPORT file\n");
+            return;
+        }
+        replies.append(app.importFromFile(std::string(rest)) ? "OK\n" : "ERR import failed\n");
+    } else if (isKeyword(verb, "CHECKPOINT")) {
+        replies.append(app.checkpoint() ? "OK\n" : "ERR no data directory or checkpoint failed\n");
+    } else if (isKeyword(verb, "PING")) {
+        replies.append("OK\n");
+    } else if (isKeyword(verb, "QUIT")) {
+        replies.append("OK\n");
+        finished = true;
+    } else if (isKeyword(verb, "SHUTDOWN")) {
+        replies.append("OK\n");
+        finished = true;
+        if (onShutdown) onShutdown();
+    } else {
+        replies.append("ERR unknown command\n");
+    }
+}
+
+void CommandSession::handleList(std::string_view options) {
+    TaskQuery query;
+    auto now = std::chrono::system_clock::now();
+    for (std::string_view option = nextWord(options); !option.empty(); option = nextWord(options)) {
+        size_t equals = option.find('=');
+        std::string_view name = option.substr(0, equals);
+        std::string_view value = equals == std::string_view::npos ? std::string_view() : option.substr(equals + 1);
+        Urgency urgency;
+        int64_t seconds;
+        size_t count;
+
+        bool valid = true;
+        if (isKeyword(name, "PENDING") && equals == std::string_view::npos) {
+            query.pending();
+        } else if (isKeyword(name, "COMPLETED") && equals == std::string_view::npos) {
+            query.completed();
+        } else if (isKeyword(name, "URGENCY") && parseUrgency(value, urgency)) {
+            query.urgency(urgency);
+        } else if (isKeyword(name, "MIN-URGENCY") && parseUrgency(value, urgency)) {
+            query.urgencyAtLeast(urgency);
+        } else if (isKeyword(name, "IDS")) {
+            size_t dash = value.find('-');
+            int first, last;
+            valid = dash != std::string_view::npos && parseNumber(value.substr(0, dash), first) &&
+                    parseNumber(value.substr(dash + 1), last);
+            if (valid) query.idsBetween(first, last);
+        } else if (isKeyword(name, "OLDER-THAN") && parseNumber(value, seconds)) {
+            query.createdBefore(now - std::chrono::seconds(seconds));
+        } else if (isKeyword(name, "NEWER-THAN") && parseNumber(value, seconds)) {
+            query.createdSince(now - std::chrono::seconds(seconds));
+        } else if (isKeyword(name, "LIMIT") && parseNumber(value, count)) {
+            query.limit(count);
+        } else if (isKeyword(name, "ORDER")) {
+            if (isKeyword(value, "ID")) {
+                query.orderBy(QueryOrder::ID);
+            } else if (isKeyword(value, "CREATED")) {
+                query.orderBy(QueryOrder::CREATED);
+            } else if (isKeyword(value, "PRIORITY")) {
+                query.orderBy(QueryOrder::PRIORITY);
+            } else {
+                valid = false;
+            }
+        } else if (isKeyword(name, "MATCH") && !value.empty()) {
+            // The search words run to the end of the line
+            std::string words(value);
+            if (!options.empty()) words.append(" ").append(options);
+            query.matching(words);
+            options = std::string_view();
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            replies.append("ERR invalid option: ");
+            appendEscaped(replies, option);
+            replies.append('\n');
+            return;
+        }
+    }
+
+    std::vector<Task> tasks = app.runQuery(query);
+    for (const Task& task : tasks) {
+        appendTask(task);
+        if (replies.size() >= kReplyFlushBytes) writeReplies();
+    }
+    replies.append("END ").appendInt(static_cast<int64_t>(tasks.size())).append('\n');
+}
+
+void CommandSession::flushRun() {
+    RunKind kind = runKind;
+    runKind = RunKind::NONE;
+    if (kind == RunKind::NONE) {
+        return;
+    }
+
+    if (kind == RunKind::ADD) {
+        BatchResult result = app.addTasks(runTasks);
+        for (size_t i = 0; i < runTasks.size(); ++i) {
+            if (result.committed) {
+                replies.append("OK ").appendInt(result.ids[i]).append('\n');
+            } else {
+                replies.append("ERR write-ahead log failed\n");
+            }
+        }
+        runTasks.clear();
+        return;
+    }
+
+    BatchResult result = kind == RunKind::DONE ? app.markCompletedBatch(runIds) : app.removeTasks(runIds);
+    std::sort(result.notFound.begin(), result.notFound.end());
+    std::sort(result.archived.begin(), result.archived.end());
+    // A task can only be removed once; later requests for it in the run did not find it
+    std::vector<bool> answered(kind == RunKind::REMOVE ? result.ids.size() : 0);
+    for (int id : runIds) {
+        if (result.committed && std::binary_search(result.archived.begin(), result.archived.end(), id)) {
+            replies.append("ERR task is in cold storage\n");
+            continue;
+        }
+        bool found = !std::binary_search(result.notFound.begin(), result.notFound.end(), id);
+        if (found && kind == RunKind::REMOVE) {
+            auto it = std::lower_bound(result.ids.begin(), result.ids.end(), id);
+            size_t position = static_cast<size_t>(it - result.ids.begin());
+            found = it != result.ids.end() && *it == id && !answered[position];
+            if (found) answered[position] = true;
+        }
+        if (!result.committed) {
+            replies.append("ERR write-ahead log failed\n");
+        } else {
+            replies.append(found ? "OK\n" : "ERR task not found\n");
+        }
+    }
+    runIds.clear();
+}
+
+void CommandSession::appendTask(const Task& task) {
+    replies.append("TASK ").appendInt(task.id).append('\t')
+           .append(urgencyName(task.urgency)).append('\t')
+           .append(task.completed ? "COMPLETED\t" : "PENDING\t")
+           .appendTimestamp(task.createdAt).append('\t');
+    appendEscaped(replies, task.description);
+    replies.append('\n');
+}
+
+void CommandSession::writeReplies() {
+    const char* data = replies.data();
+    size_t remaining = writeFailed ? 0 : replies.size();
+    while (remaining > 0) {
+        ssize_t written = write(output, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            // The peer is gone, so there is no one left to answer
+            writeFailed = true;
+            finished = true;
+            break;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    replies.clear();
+}
+
+// Unix socket server Implementation
+bool serveUnixSocket(TodoApp& app, const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cout << "Error: Socket path '" << path << "' is empty or too long!" << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int wake[2];
+    if (listener < 0) {
+        std::cout << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0 || pipe2(wake, O_CLOEXEC) != 0) {
+        std::cout << "Error: Could not listen on '" << path << "': " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    std::mutex sessionsMutex;
+    std::condition_variable sessionsDone;
+    std::set<int> connections;   // Open client sockets, guarded by sessionsMutex
+    std::atomic<bool> stopping(false);
+    auto shutdown = [&]() {
+        if (!stopping.exchange(true)) {
+            char byte = 0;
+            (void)!write(wake[1], &byte, 1);
+        }
+    };
+
+    while (!stopping) {
+        pollfd ready[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(ready, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready[1].revents != 0) {
+            break;
+        }
+        int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        connections.insert(client);
+        std::thread([&, client]() {
+            CommandSession(app, client, client, shutdown).run();
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            connections.erase(client);
+            close(client);
+            // Notify under the lock, so the server cannot return while this thread still uses it
+            sessionsDone.notify_all();
+        }).detach();
+    }
+
+    close(listener);
+    unlink(path.c_str());
+    std::unique_lock<std::mutex> lock(sessionsMutex);
+    // Idle clients would keep their sessions waiting for input; end them
+    for (int client : connections) {
+        ::shutdown(client, SHUT_RD);
+    }
+    sessionsDone.wait(lock, [&]() { return connections.empty(); });
+    close(wake[0]);
+    close(wake[1]);
+    return true;
+}
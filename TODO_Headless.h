@@ -0,0 +1,120 @@
+#ifndef TODO_HEADLESS_H
+#define TODO_HEADLESS_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TODO_App.h"
+#include "TODO_Output.h"
+
+/**
+ * @brief Non-interactive front end speaking a line-delimited protocol
+ *
+ * Requests are text lines of the form "VERB arguments". Replies come in
+ * request order: "OK [value]" or "ERR message" per request, and listing
+ * requests first send one "TASK" line per task (tab-separated ID,
+ * urgency, status, creation time and description, with backslash,
+ * tab and newline escaped) and end with "END count".
+ *
+ * - ADD urgency description: add a task, replies "OK id"
+ * - DONE id / REMOVE id: complete or remove a task
+ * - CLEAR: remove every completed task
+ * - GET id: the task with that ID
+ * - LIST [options]: tasks matching a TaskQuery built from the options
+ *   pending, completed, urgency=U, min-urgency=U, ids=A-B,
+ *   older-than=SECONDS, newer-than=SECONDS, order=id|created|priority,
+ *   limit=N, and last, match=WORDS, which takes the rest of the line
+ * - SEARCH words: tasks whose descriptions contain every word
+ * - STATS: "OK total=N pending=N completed=N"
+ * - METRICS: TodoApp::metrics() in the Prometheus text format, one
+ *   line each, then "END count" with the number of lines
+ * - EXPORT txt|csv|json|ndjson|snap file, IMPORT file, CHECKPOINT
+ * - PING, QUIT (ends the session), SHUTDOWN (also stops a server)
+ *
+ * Clients may send any number of requests without waiting for replies.
+ * Everything that arrives in one read is handled before the replies are
+ * written in one go, and consecutive ADD, DONE or REMOVE requests are
+ * applied through the batch calls, so a run of them costs one lock round
+ * and one WAL record. Nothing is prompted or flushed per request.
+ */
+class CommandSession {
+private:
+    /**
+     * @brief Kind of the mutations waiting to be applied together
+     */
+    enum class RunKind { NONE, ADD, DONE, REMOVE };
+
+    TodoApp& app;                       ///< Application the requests act on
+    int input;                          ///< Descriptor requests are read from
+    int output;                         ///< Descriptor replies are written to
+    std::function<void()> onShutdown;   ///< Called for SHUTDOWN, may be empty
+    OutputBuffer replies;               ///< Replies not yet written
+    bool writeFailed;                   ///< Set once the peer stopped reading
+    bool finished;                      ///< Set by QUIT and SHUTDOWN
+
+    RunKind runKind;                    ///< Kind of the pending mutations
+    std::vector<NewTask> runTasks;      ///< Tasks of a pending ADD run
+    std::vector<int> runIds;            ///< IDs of a pending DONE or REMOVE run
+
+    /**
+     * @brief Apply the pending mutations and reply to each of them
+     */
+    void flushRun();
+
+    /**
+     * @brief Handle one request line
+     * @param line Request without its line terminator
+     */
+    void handleLine(std::string_view line);
+
+    /**
+     * @brief Reply with the tasks matching a query
+     * @param options Option words of a LIST request
+     */
+    void handleList(std::string_view options);
+
+    /**
+     * @brief Append one TASK line to the replies
+     * @param task Task to describe
+     */
+    void appendTask(const Task& task);
+
+    /**
+     * @brief Write the pending replies
+     */
+    void writeReplies();
+
+public:
+    /**
+     * @brief Constructor
+     * @param todoApp Application the requests act on
+     * @param inputFd Descriptor to read requests from
+     * @param outputFd Descriptor to write replies to, may equal inputFd
+     * @param shutdown Called when a client sends SHUTDOWN
+     */
+    CommandSession(TodoApp& todoApp, int inputFd, int outputFd,
+                   std::function<void()> shutdown = std::function<void()>());
+
+    /**
+     * @brief Serve requests until end of input, QUIT or SHUTDOWN
+     * @return true if the session ended normally, false on an I/O error
+     */
+    bool run();
+};
+
+/**
+ * @brief Serve the line protocol to clients of a Unix domain socket
+ * @param app Application shared by every client
+ * @param path Filesystem path of the socket, replaced if it exists
+ * @return true after a SHUTDOWN request, false if the socket could not be set up
+ *
+ * Every connection is served by its own thread with a CommandSession;
+ * TodoApp is thread-safe, so clients run side by side and their
+ * mutations share WAL fsyncs through group commit. Returns once every
+ * session has ended after a SHUTDOWN request.
+ */
+bool serveUnixSocket(TodoApp& app, const std::string& path);
+
+#endif // TODO_HEADLESS_H
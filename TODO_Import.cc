@@ -0,0 +1,515 @@
+#include "TODO_Import.h"
+#include "TODO_ThreadPool.h"
+#include "TODO_Time.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+const size_t kChunkBytes = 4 << 20;   // Bytes read from the file per chunk
+
+const char kCompletedKey[] = "\"completed\"";
+const size_t kCompletedKeyLength = sizeof(kCompletedKey) - 1;
+
+/**
+ * Tasks parsed from one chunk, handed back to the reading thread
+ */
+struct ParsedChunk {
+    std::vector<ImportedTask> tasks;
+    size_t malformed;
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+// Move p backwards over whitespace, never past begin
+const char* skipSpaceBack(const char* begin, const char* p) {
+    while (p > begin && isSpace(p[-1])) --p;
+    return p;
+}
+
+bool startsWith(const char* p, const char* end, const char* token, size_t length) {
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, token, length) == 0;
+}
+
+// First occurrence of token in [begin, end), or nullptr
+const char* findForward(const char* begin, const char* end, const char* token, size_t length) {
+    const char* p = begin;
+    while (static_cast<size_t>(end - p) >= length) {
+        const void* hit = std::memchr(p, token[0], static_cast<size_t>(end - p) - length + 1);
+        if (!hit) return nullptr;
+        p = static_cast<const char*>(hit);
+        if (std::memcmp(p, token, length) == 0) return p;
+        ++p;
+    }
+    return nullptr;
+}
+
+// Last occurrence of token that lies entirely within [begin, end), or nullptr
+const char* findBackward(const char* begin, const char* end, const char* token, size_t length) {
+    if (static_cast<size_t>(end - begin) < length) return nullptr;
+    for (const char* p = end - length; p >= begin; --p) {
+        if (*p == token[0] && std::memcmp(p, token, length) == 0) return p;
+        if (p == begin) break;
+    }
+    return nullptr;
+}
+
+bool parseInt(const char* begin, const char* end, int& out) {
+    bool negative = begin < end && *begin == '-';
+    if (negative) ++begin;
+    if (begin == end || end - begin > 10) return false;
+    long long value = 0;
+    for (const char* p = begin; p < end; ++p) {
+        unsigned digit = static_cast<unsigned>(*p - '0');
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+    }
+    if (negative) value = -value;
+    if (value > 2147483647LL || value < -2147483648LL) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+bool parseUrgency(const char* begin, const char* end, Urgency& out) {
+    size_t length = static_cast<size_t>(end - begin);
+    if ((length == 3 && std::memcmp(begin, "LOW", 3) == 0) || (length == 1 && *begin == '1')) {
+        out = Urgency::LOW;
+    } else if ((length == 6 && std::memcmp(begin, "MEDIUM", 6) == 0) || (length == 1 && *begin == '2')) {
+        out = Urgency::MEDIUM;
+    } else if ((length == 4 && std::memcmp(begin, "HIGH", 4) == 0) || (length == 1 && *begin == '3')) {
+        out = Urgency::HIGH;
+    } else if ((length == 8 && std::memcmp(begin, "CRITICAL", 8) == 0) || (length == 1 && *begin == '4')) {
+        out = Urgency::CRITICAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void appendUtf8(std::string& out, unsigned codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool parseHex4(const char* p, const char* end, unsigned& out) {
+    if (end - p < 4) return false;
+    unsigned value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= static_cast<unsigned>(c - '0');
+        else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value |= static_cast<unsigned>(c - 'A' + 10);
+        else return false;
+    }
+    out = value;
+    return true;
+}
+
+// Decode JSON string escapes; unknown escapes are kept verbatim
+void unescapeJson(const char* begin, const char* end, std::string& out) {
+    out.clear();
+    out.reserve(static_cast<size_t>(end - begin));
+    for (const char* p = begin; p < end; ++p) {
+        if (*p != '\\' || p + 1 == end) {
+            out.push_back(*p);
+            continue;
+        }
+        char escape = *++p;
+        switch (escape) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                unsigned codePoint;
+                if (!parseHex4(p + 1, end, codePoint)) {
+                    out.append("\\u");
+                    break;
+                }
+                p += 4;
+                unsigned low;
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - p >= 7 &&
+                    p[1] == '\\' && p[2] == 'u' && parseHex4(p + 3, end, low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                out.push_back('\\');
+                out.push_back(escape);
+                break;
+        }
+    }
+}
+
+// CSV ------------------------------------------------------------------------
+
+// Whether the line ending just before `newline` has a CSV record's status field
+bool endsCsvRecord(const char* begin, const char* newline) {
+    const char* end = newline;
+    if (end > begin && end[-1] == '\r') --end;
+    size_t length = static_cast<size_t>(end - begin);
+    return (length >= 8 && std::memcmp(end - 8, ",PENDING", 8) == 0) ||
+           (length >= 10 && std::memcmp(end - 10, ",COMPLETED", 10) == 0);
+}
+
+size_t countQuotes(const char* begin, const char* end) {
+    return static_cast<size_t>(std::count(begin, end, '"'));
+}
+
+// Records end at a newline after a status field, outside any quoted field.
+// Chunks always start at a record, so a newline is outside the quotes when
+// an even number of quotes precede it in the chunk; a doubled quote inside
+// a field counts twice and leaves the parity unchanged.
+
+// Offset just past the last complete record in the chunk, 0 if there is none
+size_t lastCsvBoundary(const std::string& chunk) {
+    const char* data = chunk.data();
+    size_t quotesBefore = 0;
+    size_t countedTo = 0;
+    bool counted = false;
+    for (size_t i = chunk.size(); i > 0; --i) {
+        if (data[i - 1] != '\n' || !endsCsvRecord(data, data + i - 1)) continue;
+        // Count the whole prefix once, then subtract as the candidate moves back
+        if (!counted) {
+            quotesBefore = countQuotes(data, data + i - 1);
+            counted = true;
+        } else {
+            quotesBefore -= countQuotes(data + i - 1, data + countedTo);
+        }
+        countedTo = i - 1;
+        if (quotesBefore % 2 == 0) return i;
+    }
+    return 0;
+}
+
+// The newline that ends the record starting at p, or end for the final record
+const char* nextCsvRecordEnd(const char* p, const char* end) {
+    const char* lineStart = p;
+    size_t quotes = 0;
+    while (p < end) {
+        const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        if (!hit) return end;
+        const char* newline = static_cast<const char*>(hit);
+        quotes += countQuotes(p, newline);
+        if (quotes % 2 == 0 && endsCsvRecord(lineStart, newline)) return newline;
+        p = newline + 1;
+    }
+    return end;
+}
+
+bool parseCsvRecord(const char* begin, const char* end, ImportedTask& out) {
+    if (end > begin && end[-1] == '\r') --end;
+
+    const char* idComma = static_cast<const char*>(std::memchr(begin, ',', static_cast<size_t>(end - begin)));
+    if (!idComma) return false;
+    const char* statusComma = findBackward(idComma + 1, end, ",", 1);
+    if (!statusComma) return false;
+    const char* createdComma = findBackward(idComma + 1, statusComma, ",", 1);
+    if (!createdComma) return false;
+    const char* urgencyComma = findBackward(idComma + 1, createdComma, ",", 1);
+    if (!urgencyComma) return false;
+
+    if (!parseInt(begin, idComma, out.id) ||
+        !parseUrgency(urgencyComma + 1, createdComma, out.urgency) ||
+        !parseTimestamp(createdComma + 1, static_cast<size_t>(statusComma - createdComma - 1),
+                        out.createdAt)) {
+        return false;
+    }
+    if (startsWith(statusComma + 1, end, "COMPLETED", 9)) {
+        out.completed = true;
+    } else if (startsWith(statusComma + 1, end, "PENDING", 7)) {
+        out.completed = false;
+    } else {
+        return false;
+    }
+
+    const char* descBegin = idComma + 1;
+    const char* descEnd = urgencyComma;
+    out.description.clear();
+    if (descEnd - descBegin >= 2 && *descBegin == '"' && descEnd[-1] == '"') {
+        ++descBegin;
+        --descEnd;
+        for (const char* p = descBegin; p < descEnd; ++p) {
+            out.description.push_back(*p);
+            if (*p == '"' && p + 1 < descEnd && p[1] == '"') ++p;  // "" encodes one quote
+        }
+    } else {
+        out.description.assign(descBegin, descEnd);
+    }
+    return true;
+}
+
+ParsedChunk parseCsvChunk(const std::string& chunk) {
+    ParsedChunk result;
+    result.malformed = 0;
+    const char* p = chunk.data();
+    const char* end = p + chunk.size();
+
+    ImportedTask task;
+    while (p < end) {
+        const char* recordEnd = nextCsvRecordEnd(p, end);
+        if (skipSpace(p, recordEnd) != recordEnd) {
+            if (parseCsvRecord(p, recordEnd, task)) {
+                result.tasks.push_back(std::move(task));
+            } else {
+                result.malformed++;
+            }
+        }
+        p = recordEnd + (recordEnd < end ? 1 : 0);
+    }
+    return result;
+}
+
+// JSON -----------------------------------------------------------------------
+
+// If key points at a "completed" key, return the end of its enclosing object
+const char* matchCompletedEnd(const char* key, const char* end) {
+    const char* p = skipSpace(key + kCompletedKeyLength, end);
+    if (p == end || *p != ':') return nullptr;
+    p = skipSpace(p + 1, end);
+    if (startsWith(p, end, "true", 4)) p += 4;
+    else if (startsWith(p, end, "false", 5)) p += 5;
+    else return nullptr;
+    p = skipSpace(p, end);
+    return (p < end && *p == '}') ? p + 1 : nullptr;
+}
+
+size_t lastJsonBoundary(const std::string& chunk) {
+    const char* begin = chunk.data();
+    const char* end = begin + chunk.size();
+    const char* searchEnd = end;
+    while (const char* key = findBackward(begin, searchEnd, kCompletedKey, kCompletedKeyLength)) {
+        const char* objectEnd = matchCompletedEnd(key, end);
+        if (objectEnd) return static_cast<size_t>(objectEnd - begin);
+        searchEnd = key + kCompletedKeyLength - 1;
+    }
+    return 0;
+}
+
+const char* nextJsonRecordEnd(const char* p, const char* end) {
+    while (const char* key = findForward(p, end, kCompletedKey, kCompletedKeyLength)) {
+        const char* objectEnd = matchCompletedEnd(key, end);
+        if (objectEnd) return objectEnd;
+        p = key + 1;
+    }
+    return nullptr;
+}
+
+// Position just after `"key"` followed by optional spaces and a colon
+const char* findValue(const char* key, size_t keyLength, const char* end) {
+    const char* p = skipSpace(key + keyLength, end);
+    if (p == end || *p != ':') return nullptr;
+    return skipSpace(p + 1, end);
+}
+
+bool parseJsonRecord(const char* begin, const char* end, ImportedTask& out) {
+    // ID and the start of the description are found from the front
+    const char* idKey = findForward(begin, end, "\"id\"", 4);
+    if (!idKey) return false;
+    const char* idValue = findValue(idKey, 4, end);
+    if (!idValue) return false;
+    const char* idEnd = idValue;
+    while (idEnd < end && (*idEnd == '-' || (*idEnd >= '0' && *idEnd <= '9'))) ++idEnd;
+    if (!parseInt(idValue, idEnd, out.id)) return false;
+
+    const char* descKey = findForward(idEnd, end, "\"description\"", 13);
+    if (!descKey) return false;
+    const char* descValue = findValue(descKey, 13, end);
+    if (!descValue || *descValue != '"') return false;
+    const char* descBegin = descValue + 1;
+
+    // The fields after the description are found from the back, so that
+    // anything the description contains cannot be mistaken for them
+    const char* completedKey = findBackward(descBegin, end, kCompletedKey, kCompletedKeyLength);
+    if (!completedKey) return false;
+    const char* completedValue = findValue(completedKey, kCompletedKeyLength, end);
+    if (!completedValue) return false;
+    out.completed = startsWith(completedValue, end, "true", 4);
+
+    const char* createdKey = findBackward(descBegin, completedKey, "\"created\"", 9);
+    if (!createdKey) return false;
+    const char* createdValue = findValue(createdKey, 9, completedKey);
+    if (!createdValue) return false;
+    // A quoted local time, or epoch seconds written as a number
+    const char* createdText = *createdValue == '"' ? createdValue + 1 : createdValue;
+    if (!parseTimestamp(createdText, static_cast<size_t>(completedKey - createdText), out.createdAt)) {
+        return false;
+    }
+
+    const char* urgencyKey = findBackward(descBegin, createdKey, "\"urgency\"", 9);
+    if (!urgencyKey) return false;
+    const char* urgencyValue = findValue(urgencyKey, 9, createdKey);
+    if (!urgencyValue || *urgencyValue != '"') return false;
+    const char* urgencyEnd = static_cast<const char*>(
+        std::memchr(urgencyValue + 1, '"', static_cast<size_t>(createdKey - urgencyValue - 1)));
+    if (!urgencyEnd || !parseUrgency(urgencyValue + 1, urgencyEnd, out.urgency)) return false;
+
+    // Walk back from the urgency key over `",` to the closing quote
+    const char* descEnd = skipSpaceBack(descBegin, urgencyKey);
+    if (descEnd == descBegin || descEnd[-1] != ',') return false;
+    descEnd = skipSpaceBack(descBegin, descEnd - 1);
+    if (descEnd == descBegin || descEnd[-1] != '"') return false;
+    --descEnd;
+
+    unescapeJson(descBegin, descEnd, out.description);
+    return true;
+}
+
+ParsedChunk parseJsonChunk(const std::string& chunk) {
+    ParsedChunk result;
+    result.malformed = 0;
+    const char* p = chunk.data();
+    const char* end = p + chunk.size();
+
+    ImportedTask task;
+    while (const char* recordEnd = nextJsonRecordEnd(p, end)) {
+        if (parseJsonRecord(p, recordEnd, task)) {
+            result.tasks.push_back(std::move(task));
+        } else {
+            result.malformed++;
+        }
+        p = recordEnd;
+    }
+    return result;
+}
+
+// Read until the buffer holds `want` more bytes or the file ends
+size_t readChunk(int fd, std::string& buffer, size_t want) {
+    size_t start = buffer.size();
+    buffer.resize(start + want);
+    size_t done = 0;
+    while (done < want) {
+        ssize_t got = ::read(fd, &buffer[start + done], want - done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += static_cast<size_t>(got);
+    }
+    buffer.resize(start + done);
+    return done;
+}
+
+} // namespace
+
+ImportFormat detectImportFormat(const std::string& filename) {
+    if ((filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0) ||
+        (filename.size() >= 7 && filename.compare(filename.size() - 7, 7, ".ndjson") == 0)) {
+        return ImportFormat::JSON;
+    }
+    if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0) {
+        return ImportFormat::CSV;
+    }
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return ImportFormat::CSV;
+    char head[64];
+    ssize_t got = ::read(fd, head, sizeof(head));
+    ::close(fd);
+    const char* first = skipSpace(head, head + (got > 0 ? got : 0));
+    return (first < head + (got > 0 ? got : 0) && *first == '{') ? ImportFormat::JSON
+                                                                 : ImportFormat::CSV;
+}
+
+ImportStats streamImport(const std::string& filename, ImportFormat format, ThreadPool& pool,
+                         const std::function<void(std::vector<ImportedTask>&)>& consume) {
+    ImportStats stats;
+    stats.opened = false;
+    stats.imported = 0;
+    stats.malformed = 0;
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return stats;
+    stats.opened = true;
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Keep every worker busy while bounding how much of the file is in memory
+    const size_t maxInFlight = pool.size() * 2 + 1;
+    std::deque<std::future<ParsedChunk>> inFlight;
+    auto collectOldest = [&] {
+        ParsedChunk parsed = inFlight.front().get();
+        inFlight.pop_front();
+        stats.imported += parsed.tasks.size();
+        stats.malformed += parsed.malformed;
+        if (!parsed.tasks.empty()) consume(parsed.tasks);
+    };
+
+    std::string carry;
+    bool firstChunk = true;
+    while (true) {
+        std::shared_ptr<std::string> chunk = std::make_shared<std::string>();
+        chunk->reserve(carry.size() + kChunkBytes);
+        chunk->swap(carry);
+        bool atEnd = readChunk(fd, *chunk, kChunkBytes) == 0;
+
+        if (firstChunk && format == ImportFormat::CSV) {
+            // Drop the header line written by exportToCSV()
+            if (chunk->compare(0, 3, "ID,") == 0) {
+                size_t newline = chunk->find('\n');
+                if (newline == std::string::npos && !atEnd) {
+                    carry.swap(*chunk);
+                    continue;
+                }
+                chunk->erase(0, newline == std::string::npos ? chunk->size() : newline + 1);
+            }
+        }
+        firstChunk = false;
+
+        size_t boundary = atEnd ? chunk->size()
+                                : (format == ImportFormat::CSV ? lastCsvBoundary(*chunk)
+                                                               : lastJsonBoundary(*chunk));
+        if (boundary < chunk->size()) {
+            carry.assign(*chunk, boundary, std::string::npos);
+            chunk->resize(boundary);
+        }
+
+        if (!chunk->empty()) {
+            if (format == ImportFormat::CSV) {
+                inFlight.push_back(pool.submit([chunk] { return parseCsvChunk(*chunk); }));
+            } else {
+                inFlight.push_back(pool.submit([chunk] { return parseJsonChunk(*chunk); }));
+            }
+        }
+        while (inFlight.size() >= maxInFlight) collectOldest();
+        if (atEnd) break;
+    }
+    while (!inFlight.empty()) collectOldest();
+
+    ::close(fd);
+    return stats;
+}
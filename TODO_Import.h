@@ -0,0 +1,74 @@
+#ifndef TODO_IMPORT_H
+#define TODO_IMPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "TODO_App.h"
+
+class ThreadPool;
+
+/**
+ * @brief Text formats understood by the streaming importer
+ */
+enum class ImportFormat {
+    CSV,   ///< Output of TodoApp::exportToCSV()
+    JSON   ///< Output of TodoApp::exportToJSON() or exportToNDJSON()
+};
+
+/**
+ * @brief One task parsed from an export file
+ */
+struct ImportedTask {
+    int id;                                              ///< Task ID found in the file
+    std::string description;                             ///< Unquoted, unescaped description
+    Urgency urgency;                                     ///< Urgency level
+    std::chrono::system_clock::time_point createdAt;     ///< Creation timestamp
+    bool completed;                                      ///< Completion status
+};
+
+/**
+ * @brief Outcome of a streaming import
+ */
+struct ImportStats {
+    bool opened;          ///< false if the file could not be read at all
+    size_t imported;      ///< Number of tasks handed to the consumer
+    size_t malformed;     ///< Number of records that could not be parsed
+};
+
+/**
+ * @brief Guess the text format of an export file
+ * @param filename Name of the file
+ * @return JSON for ".json" and ".ndjson" files or content starting with '{', CSV otherwise
+ */
+ImportFormat detectImportFormat(const std::string& filename);
+
+/**
+ * @brief Stream tasks out of a CSV or JSON export, parsing in parallel
+ * @param filename Name of the export file
+ * @param format Format of the file
+ * @param pool Worker threads used for parsing
+ * @param consume Called on the calling thread with every parsed batch, in file order
+ * @return Counts of imported and malformed records
+ *
+ * Reads the file in fixed-size chunks and cuts each chunk at the last
+ * complete record, carrying the remainder into the next chunk. Chunks
+ * are parsed on the pool while the next ones are read, and only a small
+ * bounded number of chunks is in flight at once, so memory use does not
+ * depend on the file size.
+ *
+ * Records are recognized by the fields that exportToCSV()/exportToJSON()
+ * always write last (the status in CSV, the "completed" flag in JSON),
+ * and the description is taken as everything between the fields around
+ * it. A CSV record only ends outside a quoted field, so descriptions may
+ * contain commas, quotes and newlines, even a line that looks like the
+ * end of a record; doubled quotes in CSV and backslash escapes in JSON
+ * are decoded.
+ */
+ImportStats streamImport(const std::string& filename, ImportFormat format, ThreadPool& pool,
+                         const std::function<void(std::vector<ImportedTask>&)>& consume);
+
+#endif // TODO_IMPORT_H
@@ -0,0 +1,222 @@
+#ifndef TODO_INDEX_H
+#define TODO_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Sorted set of keys stored in small sorted chunks
+ * @tparam Key Key type, ordered by operator<
+ *
+ * A flat sorted vector gives the fastest iteration but makes inserting or
+ * erasing in the middle O(n); a node-based std::set fixes that at the cost
+ * of a heap node per key. This keeps keys in sorted chunks of at most
+ * kChunkCapacity entries: lookups binary-search the chunk list and then
+ * one chunk, updates shift at most one chunk, and iteration walks a few
+ * contiguous arrays. Appending a key larger than every key in the set,
+ * the common case since task IDs and creation times only grow, is O(1).
+ */
+template <typename Key>
+class OrderedSet {
+private:
+    static const size_t kChunkCapacity = 512;   ///< Maximum keys per chunk
+
+    std::vector<std::vector<Key>> chunks;   ///< Non-empty sorted chunks, in order
+    std::vector<Key> spare;                 ///< Emptied chunk kept for reuse, so churn does not reallocate
+    size_t count;                           ///< Total number of keys
+
+    /**
+     * @brief Append an empty chunk, reusing the spare chunk's storage if any
+     */
+    void appendChunk() {
+        chunks.emplace_back(std::move(spare));
+        spare = std::vector<Key>();
+        if (chunks.back().capacity() < kChunkCapacity) {
+            chunks.back().reserve(kChunkCapacity);
+        }
+    }
+
+    /**
+     * @brief Find the chunk that holds or would hold a key
+     * @param key Key to look for
+     * @return Index of the first chunk whose last key is not less than key,
+     *         or chunks.size() if key is greater than every key in the set
+     */
+    size_t findChunk(const Key& key) const {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), key,
+            [](const std::vector<Key>& chunk, const Key& value) { return chunk.back() < value; });
+        return static_cast<size_t>(it - chunks.begin());
+    }
+
+public:
+    /**
+     * @brief Forward iterator over the keys in ascending order
+     *
+     * Invalidated by any insert(), erase() or clear() on the set.
+     */
+    class const_iterator {
+    private:
+        const std::vector<std::vector<Key>>* chunks;
+        size_t chunk;
+        size_t position;
+
+        friend class OrderedSet;
+        const_iterator(const std::vector<std::vector<Key>>* owner, size_t chunkIndex, size_t offset = 0)
+            : chunks(owner), chunk(chunkIndex), position(offset) {}
+
+    public:
+        const_iterator() : chunks(nullptr), chunk(0), position(0) {}
+
+        const Key& operator*() const { return (*chunks)[chunk][position]; }
+
+        const_iterator& operator++() {
+            if (++position == (*chunks)[chunk].size()) {
+                ++chunk;
+                position = 0;
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return chunk == other.chunk && position == other.position;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    OrderedSet() : count(0) {}
+
+    /**
+     * @brief Add a key to the set
+     * @param key Key to add, ignored if already present
+     */
+    void insert(const Key& key) {
+        // Fast path: append after the largest key
+        if (chunks.empty() || chunks.back().back() < key) {
+            if (chunks.empty() || chunks.back().size() >= kChunkCapacity) {
+                appendChunk();
+            }
+            chunks.back().push_back(key);
+            count++;
+            return;
+        }
+
+        size_t index = findChunk(key);
+        std::vector<Key>& chunk = chunks[index];
+        auto position = std::lower_bound(chunk.begin(), chunk.end(), key);
+        if (!(key < *position)) {
+            return;   // Already present
+        }
+        chunk.insert(position, key);
+        count++;
+
+        // Split a full chunk in half so later inserts stay cheap
+        if (chunk.size() > kChunkCapacity) {
+            std::vector<Key> upper(chunk.begin() + chunk.size() / 2, chunk.end());
+            upper.reserve(kChunkCapacity);
+            chunk.resize(chunk.size() / 2);
+            chunks.insert(chunks.begin() + index + 1, std::move(upper));
+        }
+    }
+
+    /**
+     * @brief Remove a key from the set
+     * @param key Key to remove
+     * @return true if the key was present, false otherwise
+     */
+    bool erase(const Key& key) {
+        size_t index = findChunk(key);
+        if (index == chunks.size()) {
+            return false;
+        }
+        std::vector<Key>& chunk = chunks[index];
+        auto position = std::lower_bound(chunk.begin(), chunk.end(), key);
+        if (key < *position) {
+            return false;
+        }
+        chunk.erase(position);
+        count--;
+
+        if (chunk.empty()) {
+            if (chunk.capacity() > spare.capacity()) {
+                spare.swap(chunk);
+            }
+            chunks.erase(chunks.begin() + index);
+        } else if (index + 1 < chunks.size() && chunk.size() < kChunkCapacity / 4 &&
+                   chunk.size() + chunks[index + 1].size() <= kChunkCapacity / 2) {
+            // Merge sparse neighbours so heavy removal does not leave many tiny chunks
+            chunk.insert(chunk.end(), chunks[index + 1].begin(), chunks[index + 1].end());
+            chunks.erase(chunks.begin() + index + 1);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check whether a key is in the set
+     * @param key Key to look for
+     * @return true if present, false otherwise
+     */
+    bool contains(const Key& key) const {
+        size_t index = findChunk(key);
+        return index < chunks.size() &&
+               std::binary_search(chunks[index].begin(), chunks[index].end(), key);
+    }
+
+    /**
+     * @brief Find the first key that is not less than a given key
+     * @param key Key to look for
+     * @return Iterator to that key, or end() if every key is less
+     */
+    const_iterator lower_bound(const Key& key) const {
+        size_t index = findChunk(key);
+        if (index == chunks.size()) {
+            return end();
+        }
+        const std::vector<Key>& chunk = chunks[index];
+        size_t offset = static_cast<size_t>(std::lower_bound(chunk.begin(), chunk.end(), key) - chunk.begin());
+        return const_iterator(&chunks, index, offset);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @brief Remove every key and release the storage
+     */
+    void clear() {
+        std::vector<std::vector<Key>>().swap(chunks);
+        std::vector<Key>().swap(spare);
+        count = 0;
+    }
+
+    const_iterator begin() const { return const_iterator(&chunks, 0); }
+    const_iterator end() const { return const_iterator(&chunks, chunks.size()); }
+};
+
+/**
+ * @brief Set of task IDs in ascending order, which is insertion order
+ */
+typedef OrderedSet<int> OrderedIdSet;
+
+/**
+ * @brief Position of a task in priority order within one urgency level
+ *
+ * Orders by creation time, oldest first, and breaks ties by ID so that
+ * every task has a distinct, stable key.
+ */
+struct PriorityKey {
+    int64_t createdAt;   ///< Creation time as system_clock ticks since the epoch
+    int id;              ///< Task ID
+
+    bool operator<(const PriorityKey& other) const {
+        return createdAt != other.createdAt ? createdAt < other.createdAt : id < other.id;
+    }
+};
+
+/**
+ * @brief Set of tasks of one urgency level in priority order
+ */
+typedef OrderedSet<PriorityKey> PrioritySet;
+
+#endif // TODO_INDEX_H
@@ -0,0 +1,225 @@
+#include "TODO_Logger.h"
+#include "TODO_Metrics.h"
+#include "TODO_Time.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kBatchBytes = 64 * 1024;                        // Write once this much is buffered
+const std::chrono::milliseconds kIdleWait(100);              // Longest sleep without a sync deadline
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Write the whole buffer, retrying on partial writes and interrupts
+void writeAll(int fd, const std::string& buffer) {
+    const char* data = buffer.data();
+    size_t left = buffer.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return; // Nothing sensible to do if the log file is unwritable
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+}
+
+} // namespace
+
+ActionLogger::ActionLogger(const std::string& fileName, const LogSyncPolicy& syncPolicy,
+                           size_t capacity, MetricsRegistry* metricsRegistry)
+    : slots(new Slot[roundUpToPowerOfTwo(capacity)]),
+      mask(roundUpToPowerOfTwo(capacity) - 1),
+      enqueuePos(0), dequeuePos(0), fd(-1), policy(syncPolicy), metrics(metricsRegistry),
+      stopping(false), writerSleeping(false) {
+    for (size_t i = 0; i <= mask; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    writer = std::thread(&ActionLogger::writerLoop, this);
+}
+
+ActionLogger::~ActionLogger() {
+    stop();
+}
+
+bool ActionLogger::tryPush(std::string& message) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* cell;
+    while (true) {
+        cell = &slots[pos & mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // The writer has not consumed this cell from the previous lap
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->time = std::chrono::system_clock::now();
+    cell->message.swap(message);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool ActionLogger::hasPending() const {
+    const Slot& cell = slots[dequeuePos & mask];
+    return cell.sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+}
+
+void ActionLogger::wakeWriter() {
+    // Pairs with the fence in writerLoop: either the writer sees the new
+    // entry before sleeping, or we see that it is asleep and notify it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+void ActionLogger::log(std::string message) {
+    logSwap(message);
+}
+
+void ActionLogger::logSwap(std::string& message) {
+    if (stopping.load(std::memory_order_relaxed)) return;
+    while (!tryPush(message)) {
+        // The writer will not drain the ring again once it has stopped
+        if (stopping.load(std::memory_order_relaxed)) return;
+        wakeWriter();
+        std::this_thread::yield();
+    }
+    wakeWriter();
+}
+
+void ActionLogger::stop() {
+    if (stopping.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+    if (writer.joinable()) writer.join();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void ActionLogger::writerLoop() {
+    typedef std::chrono::steady_clock Clock;
+
+    std::string batch;
+    batch.reserve(kBatchBytes * 2);
+    size_t batchEntries = 0;
+    size_t unsyncedEntries = 0;
+    Clock::time_point oldestUnsynced;
+
+    auto syncFile = [this] {
+        if (metrics) {
+            MetricsRegistry::Timer timer(*metrics, MetricOp::LOG_SYNC, 0);
+            ::fsync(fd);
+        } else {
+            ::fsync(fd);
+        }
+    };
+
+    auto writeBatch = [this, &batch, &batchEntries] {
+        if (fd >= 0) {
+            if (metrics) {
+                MetricsRegistry::Timer timer(*metrics, MetricOp::LOG_FLUSH, batchEntries);
+                writeAll(fd, batch);
+            } else {
+                writeAll(fd, batch);
+            }
+        }
+        batch.clear();
+        batchEntries = 0;
+    };
+
+    // The timestamp prefix only changes once per second, so format it lazily
+    std::time_t cachedSecond = -1;
+    char prefix[kTimestampLength + 3] = {'['};
+    prefix[kTimestampLength + 1] = ']';
+    prefix[kTimestampLength + 2] = ' ';
+
+    while (true) {
+        bool stopRequested = stopping.load(std::memory_order_acquire);
+        // A producer may have claimed a cell without publishing it yet;
+        // on the last pass wait for every cell claimed before the stop
+        size_t drainTarget = stopRequested ? enqueuePos.load(std::memory_order_acquire) : 0;
+
+        while (true) {
+            if (!hasPending()) {
+                if (dequeuePos >= drainTarget) break;
+                std::this_thread::yield();
+                continue;
+            }
+            Slot& cell = slots[dequeuePos & mask];
+            std::time_t second = std::chrono::system_clock::to_time_t(cell.time);
+            if (second != cachedSecond) {
+                formatLocalTimestamp(cell.time, prefix + 1);
+                cachedSecond = second;
+            }
+            batch.append(prefix, sizeof(prefix));
+            batch.append(cell.message);
+            batch.push_back('\n');
+            batchEntries++;
+            cell.message.clear();
+            cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+            ++dequeuePos;
+
+            if (unsyncedEntries++ == 0) oldestUnsynced = Clock::now();
+            if (batch.size() >= kBatchBytes) {
+                writeBatch();
+            }
+        }
+        if (!batch.empty()) {
+            writeBatch();
+        }
+
+        if (unsyncedEntries > 0 && fd >= 0) {
+            bool syncNow = (policy.everyEntries > 0 && unsyncedEntries >= policy.everyEntries) ||
+                           (policy.everyInterval.count() > 0 &&
+                            Clock::now() - oldestUnsynced >= policy.everyInterval);
+            if (syncNow) {
+                syncFile();
+                unsyncedEntries = 0;
+            }
+        }
+
+        // Entries claimed before stop() was observed have all been drained
+        if (stopRequested) break;
+
+        std::chrono::milliseconds wait = kIdleWait;
+        if (unsyncedEntries > 0 && policy.everyInterval.count() > 0) {
+            wait = std::min(wait, policy.everyInterval);
+        }
+
+        writerSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, wait, [this] {
+                return hasPending() || stopping.load(std::memory_order_acquire);
+            });
+        }
+        writerSleeping.store(false, std::memory_order_relaxed);
+    }
+
+    if (unsyncedEntries > 0 && fd >= 0 && policy.onShutdown) {
+        syncFile();
+    }
+}
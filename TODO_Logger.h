@@ -0,0 +1,160 @@
+#ifndef TODO_LOGGER_H
+#define TODO_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class MetricsRegistry;
+
+/**
+ * @brief Durability policy for the action log
+ *
+ * Controls when the background writer calls fsync() on the log file.
+ * Each trigger is independent and a zero value disables it, so the
+ * default policy only syncs once when the logger shuts down.
+ */
+struct LogSyncPolicy {
+    size_t everyEntries;                       ///< Sync after this many entries (0 = disabled)
+    std::chrono::milliseconds everyInterval;   ///< Sync when unsynced entries are this old (0 = disabled)
+    bool onShutdown;                           ///< Sync when the logger is stopped
+
+    /**
+     * @brief Constructor for LogSyncPolicy
+     *
+     * Creates the default policy: no periodic syncs, one sync on shutdown.
+     */
+    LogSyncPolicy() : everyEntries(0), everyInterval(0), onShutdown(true) {}
+};
+
+/**
+ * @brief Asynchronous, batching writer for the action log
+ *
+ * Producers push messages into a bounded lock-free multi-producer,
+ * single-consumer ring buffer. A dedicated writer thread drains the ring,
+ * prefixes each entry with the timestamp captured at the time of the
+ * push, and appends whole batches to the log file with a single write()
+ * call. The file is opened once for the lifetime of the logger.
+ */
+class ActionLogger {
+private:
+    /**
+     * @brief One cell of the ring buffer
+     *
+     * The sequence number tells producers and the consumer whether the
+     * cell is free for the current lap or holds a published entry.
+     */
+    struct Slot {
+        std::atomic<size_t> sequence;                 ///< Publication sequence for this cell
+        std::chrono::system_clock::time_point time;   ///< Time the entry was logged
+        std::string message;                          ///< Log message text
+    };
+
+    std::unique_ptr<Slot[]> slots;         ///< Ring buffer storage
+    size_t mask;                           ///< Capacity minus one (capacity is a power of two)
+    std::atomic<size_t> enqueuePos;        ///< Next position claimed by a producer
+    size_t dequeuePos;                     ///< Next position read by the writer thread
+
+    int fd;                                ///< File descriptor of the log file, -1 if unavailable
+    LogSyncPolicy policy;                  ///< When to fsync the log file
+    MetricsRegistry* metrics;              ///< Receives LOG_FLUSH and LOG_SYNC records, may be null
+
+    std::atomic<bool> stopping;            ///< Set when the logger is shutting down
+    std::atomic<bool> writerSleeping;      ///< Set while the writer waits for new entries
+    std::mutex wakeMutex;                  ///< Protects writer sleep/wake transitions
+    std::condition_variable wakeCondition; ///< Signals the writer that entries are available
+    std::thread writer;                    ///< Background writer thread
+
+    /**
+     * @brief Try to publish an entry into the ring buffer
+     * @param message Message to move into the ring
+     * @return true if the entry was published, false if the ring is full
+     */
+    bool tryPush(std::string& message);
+
+    /**
+     * @brief Check whether the writer has an entry ready to read
+     * @return true if the next cell holds a published entry
+     */
+    bool hasPending() const;
+
+    /**
+     * @brief Wake the writer thread if it is waiting for entries
+     */
+    void wakeWriter();
+
+    /**
+     * @brief Main loop of the background writer thread
+     *
+     * Drains the ring into a batch buffer, writes the batch, applies the
+     * sync policy and sleeps until more entries arrive or a periodic sync
+     * becomes due.
+     */
+    void writerLoop();
+
+public:
+    /**
+     * @brief Constructor for ActionLogger
+     * @param fileName Name of the log file to append to
+     * @param syncPolicy When to fsync the log file
+     * @param capacity Number of ring buffer cells (rounded up to a power of two)
+     * @param metricsRegistry Registry to record every batch write into as
+     *                        MetricOp::LOG_FLUSH and every fsync as
+     *                        MetricOp::LOG_SYNC, or null; must outlive the
+     *                        logger
+     *
+     * Opens the log file in append mode and starts the writer thread.
+     * If the file cannot be opened, entries are silently discarded.
+     */
+    explicit ActionLogger(const std::string& fileName,
+                          const LogSyncPolicy& syncPolicy = LogSyncPolicy(),
+                          size_t capacity = 4096,
+                          MetricsRegistry* metricsRegistry = nullptr);
+
+    /**
+     * @brief Destructor for ActionLogger
+     *
+     * Stops the writer thread after all pending entries are written.
+     */
+    ~ActionLogger();
+
+    ActionLogger(const ActionLogger&) = delete;
+    ActionLogger& operator=(const ActionLogger&) = delete;
+
+    /**
+     * @brief Queue a message for the log
+     * @param message Message text, without timestamp or trailing newline
+     *
+     * Records the current time and publishes the message to the writer
+     * thread without taking a lock or touching the file. Only blocks when
+     * the ring buffer is full, until the writer has made room.
+     */
+    void log(std::string message);
+
+    /**
+     * @brief Queue a message held in a reusable buffer
+     * @param message Message text; on return holds an empty buffer that
+     *                the ring had already finished with
+     *
+     * Like log(), but hands the message's storage to the ring in exchange
+     * for a drained cell's, so a caller that formats every message into
+     * the same string stops allocating once the cells have grown.
+     */
+    void logSwap(std::string& message);
+
+    /**
+     * @brief Stop the writer thread
+     *
+     * Writes every entry queued before the call, applies the shutdown
+     * sync policy and closes the file. Safe to call more than once;
+     * messages logged afterwards are discarded.
+     */
+    void stop();
+};
+
+#endif // TODO_LOGGER_H
@@ -0,0 +1,438 @@
+#include "TODO_App.h"
+#include "TODO_Headless.h"
+#include "TODO_Server.h"
+#include <csignal>
+#include <cstdlib>
+#include <limits>
+#include <unistd.h>
+
+// Interactive menu functions
+void displayMenu() {
+    std::cout << "\n=== TODO APP MENU ===" << std::endl;
+    std::cout << "1. Add Task" << std::endl;
+    std::cout << "2. View All Tasks" << std::endl;
+    std::cout << "3. View Tasks Sorted by Urgency" << std::endl;
+    std::cout << "4. Mark Task as Completed" << std::endl;
+    std::cout << "5. Remove Task" << std::endl;
+    std::cout << "6. View Statistics" << std::endl;
+    std::cout << "7. Export Tasks" << std::endl;
+    std::cout << "8. Clear Completed Tasks" << std::endl;
+    std::cout << "9. Filter Tasks by Urgency" << std::endl;
+    std::cout << "10. Import Tasks" << std::endl;
+    std::cout << "11. Search Tasks" << std::endl;
+    std::cout << "0. Exit" << std::endl;
+    std::cout << "Enter your choice: ";
+}
+
+void displayUrgencyMenu() {
+    std::cout << "\nSelect urgency level:" << std::endl;
+    std::cout << "1. Low" << std::endl;
+    std::cout << "2. Medium" << std::endl;
+    std::cout << "3. High" << std::endl;
+    std::cout << "4. Critical" << std::endl;
+    std::cout << "Enter urgency (1-4): ";
+}
+
+void displayExportMenu() {
+    std::cout << "\nSelect export format:" << std::endl;
+    std::cout << "1. Text file (.txt)" << std::endl;
+    std::cout << "2. CSV file (.csv)" << std::endl;
+    std::cout << "3. JSON file (.json)" << std::endl;
+    std::cout << "4. Binary snapshot (.snap)" << std::endl;
+    std::cout << "5. Newline-delimited JSON (.ndjson)" << std::endl;
+    std::cout << "Enter format (1-5): ";
+}
+
+Urgency getUserUrgency() {
+    int choice;
+    while (true) {
+        displayUrgencyMenu();
+        if (std::cin >> choice && choice >= 1 && choice <= 4) {
+            std::cin.ignore(); // Clear the newline
+            return intToUrgency(choice);
+        } else {
+            std::cout << "Invalid input! Please enter a number between 1-4." << std::endl;
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+    }
+}
+
+std::string getUserInput(const std::string& prompt) {
+    std::string input;
+    std::cout << prompt;
+    std::getline(std::cin, input);
+    return input;
+}
+
+int getUserChoice() {
+    int choice;
+    while (true) {
+        if (std::cin >> choice) {
+            std::cin.ignore(); // Clear the newline
+            return choice;
+        } else {
+            std::cout << "Invalid input! Please enter a number: ";
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+    }
+}
+
+const size_t kMenuPageRows = 50;       // Tasks per page of an interactive listing
+const size_t kStreamPageRows = 4096;   // Tasks rendered per lock hold while streaming
+
+/**
+ * @brief Show a listing page by page until it ends or the user stops
+ * @param showPage Callable that displays the page after a cursor and
+ *                 returns the cursor after that page
+ */
+template <typename ShowPage>
+void pageThrough(ShowPage showPage) {
+    TaskCursor cursor = showPage(TaskCursor());
+    while (cursor.started && !cursor.atEnd) {
+        std::string answer = getUserInput("-- More tasks: press Enter for the next page, q to stop -- ");
+        if (!answer.empty() && (answer[0] == 'q' || answer[0] == 'Q')) {
+            return;
+        }
+        cursor = showPage(cursor);
+    }
+}
+
+void handleViewTasks(TodoApp& app) {
+    pageThrough([&app](const TaskCursor& after) { return app.displayTasksPage(kMenuPageRows, after); });
+}
+
+void handleViewTasksByUrgency(TodoApp& app) {
+    pageThrough([&app](const TaskCursor& after) {
+        return app.displayTasksSortedByUrgencyPage(kMenuPageRows, after);
+    });
+}
+
+void handleAddTask(TodoApp& app) {
+    std::string description = getUserInput("Enter task description: ");
+    if (description.empty()) {
+        std::cout << "Task description cannot be empty!" << std::endl;
+        return;
+    }
+    
+    Urgency urgency = getUserUrgency();
+    app.addTask(std::move(description), urgency);
+}
+
+void handleMarkCompleted(TodoApp& app) {
+    if (app.getTotalTasks() == 0) {
+        std::cout << "No tasks available!" << std::endl;
+        return;
+    }
+    
+    handleViewTasks(app);
+    std::cout << "Enter task ID to mark as completed: ";
+    int id = getUserChoice();
+    app.markCompleted(id);
+}
+
+void handleRemoveTask(TodoApp& app) {
+    if (app.getTotalTasks() == 0) {
+        std::cout << "No tasks available!" << std::endl;
+        return;
+    }
+    
+    handleViewTasks(app);
+    std::cout << "Enter task ID to remove: ";
+    int id = getUserChoice();
+    app.removeTask(id);
+}
+
+void handleExportTasks(TodoApp& app) {
+    if (app.getTotalTasks() == 0) {
+        std::cout << "No tasks to export!" << std::endl;
+        return;
+    }
+    
+    int choice;
+    displayExportMenu();
+    choice = getUserChoice();
+    
+    std::string filename = getUserInput("Enter filename (without extension): ");
+    if (filename.empty()) {
+        filename = "todo_export";
+    }
+    
+    bool success = false;
+    switch (choice) {
+        case 1:
+            success = app.exportToFile(filename + ".txt");
+            break;
+        case 2:
+            success = app.exportToCSV(filename + ".csv");
+            break;
+        case 3:
+            success = app.exportToJSON(filename + ".json");
+            break;
+        case 4:
+            success = app.saveSnapshot(filename + ".snap");
+            break;
+        case 5:
+            success = app.exportToNDJSON(filename + ".ndjson");
+            break;
+        default:
+            std::cout << "Invalid choice!" << std::endl;
+            return;
+    }
+    
+    if (!success) {
+        std::cout << "Export failed!" << std::endl;
+    }
+}
+
+void handleImportTasks(TodoApp& app) {
+    std::string filename = getUserInput("Enter filename to import: ");
+    if (filename.empty()) {
+        std::cout << "Filename cannot be empty!" << std::endl;
+        return;
+    }
+    
+    if (!app.importFromFile(filename)) {
+        std::cout << "Import failed!" << std::endl;
+    }
+}
+
+void handleFilterByUrgency(TodoApp& app) {
+    if (app.getTotalTasks() == 0) {
+        std::cout << "No tasks available!" << std::endl;
+        return;
+    }
+    
+    Urgency urgency = getUserUrgency();
+    TaskFilter filter;
+    filter.urgency = urgency;
+    TaskTable table("TASKS WITH " + urgencyToString(urgency) + " URGENCY",
+                    COLUMN_ID | COLUMN_DESCRIPTION | COLUMN_CREATED | COLUMN_STATUS);
+    TaskCursor cursor;
+    do {
+        cursor = app.visitPage(PageOrder::ID, cursor, kStreamPageRows, filter,
+                               [&table](const TaskRef& task) { table.addRow(task); });
+        if (!cursor.started) {
+            std::cout << "No tasks found with " << urgencyToString(urgency) << " urgency." << std::endl;
+            return;
+        }
+        // Each page is shown as soon as it is rendered, outside the lock
+        table.flushTo(app.outputSink());
+    } while (!cursor.atEnd);
+    table.writeTo(app.outputSink());
+}
+
+void handleSearchTasks(TodoApp& app) {
+    std::string query = getUserInput("Enter words to search for (end a word with * to match prefixes): ");
+    std::vector<Task> matches = app.searchTasks(query);
+    
+    if (matches.empty()) {
+        std::cout << "No tasks match \"" << query << "\"." << std::endl;
+        return;
+    }
+    
+    TaskTable table("TASKS MATCHING \"" + query + "\"",
+                    COLUMN_ID | COLUMN_DESCRIPTION | COLUMN_URGENCY | COLUMN_STATUS);
+    for (const Task& task : matches) {
+        table.addRow(task);
+    }
+    table.writeTo(app.outputSink());
+}
+
+/**
+ * @brief Sink of the headless modes: errors go to stderr, the rest is dropped
+ */
+class HeadlessSink : public NullSink {
+public:
+    void message(MessageLevel level, std::string_view text) override {
+        if (level == MessageLevel::ERROR) {
+            std::cerr << text << std::endl;
+        }
+    }
+};
+
+/**
+ * @brief Open the cold tier and start moving old completed tasks into it
+ * @param app Application to configure
+ * @param directory Directory of the cold segments
+ * @param hours Value of --cold-after, empty to only move tasks on request
+ * @return false if the directory cannot be opened or the age is invalid
+ */
+bool openColdTier(TodoApp& app, const std::string& directory, const std::string& hours) {
+    char* end = nullptr;
+    unsigned long age = hours.empty() ? 0 : std::strtoul(hours.c_str(), &end, 10);
+    if (!hours.empty() && (*end != '\0' || age == 0)) {
+        std::cerr << "Error: Invalid age '" << hours << "' for --cold-after!" << std::endl;
+        return false;
+    }
+    if (!app.openColdStorage(directory)) {
+        return false;
+    }
+    if (age > 0) {
+        RetentionPolicy policy;
+        policy.completedAge = std::chrono::hours(age);
+        policy.coldStorage = true;
+        app.setRetentionPolicy(policy);
+    }
+    return true;
+}
+
+/**
+ * @brief Run the RPC server until SIGINT or SIGTERM
+ * @param app Application to serve
+ * @param address "[HOST:]PORT", HOST defaulting to 127.0.0.1
+ * @return true after a clean shutdown, false if the server could not start
+ */
+bool serveRpc(TodoApp& app, const std::string& address) {
+    size_t colon = address.rfind(':');
+    std::string host = colon == std::string::npos ? "127.0.0.1" : address.substr(0, colon);
+    std::string portText = colon == std::string::npos ? address : address.substr(colon + 1);
+    char* end = nullptr;
+    unsigned long port = std::strtoul(portText.c_str(), &end, 10);
+    if (portText.empty() || *end != '\0' || port > 65535) {
+        std::cout << "Error: Invalid RPC address '" << address << "'!" << std::endl;
+        return false;
+    }
+    
+    // Block the stop signals before the loops start, so only sigwait() sees them
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+    
+    RpcServer server(app);
+    if (!server.start(host, static_cast<uint16_t>(port))) {
+        return false;
+    }
+    std::cout << "Serving RPC on " << host << ":" << server.port()
+              << ", metrics at http://" << host << ":" << server.port() << "/metrics" << std::endl;
+    int received;
+    sigwait(&stopSignals, &received);
+    server.stop();
+    return true;
+}
+
+// Interactive main function
+int main(int argc, char* argv[]) {
+    std::string dataDirectory;
+    std::string coldDirectory;
+    std::string coldAfter;
+    std::string socketPath;
+    std::string rpcAddress;
+    bool batch = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data-dir" && i + 1 < argc) {
+            dataDirectory = argv[++i];
+        } else if (arg == "--cold-dir" && i + 1 < argc) {
+            coldDirectory = argv[++i];
+        } else if (arg == "--cold-after" && i + 1 < argc) {
+            coldAfter = argv[++i];
+        } else if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--rpc" && i + 1 < argc) {
+            rpcAddress = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--data-dir DIRECTORY] [--cold-dir DIRECTORY [--cold-after HOURS]]"
+                      << " [--batch | --socket PATH | --rpc [HOST:]PORT]" << std::endl;
+            return 1;
+        }
+    }
+    if (!coldAfter.empty() && coldDirectory.empty()) {
+        std::cout << "Error: --cold-after needs --cold-dir!" << std::endl;
+        return 1;
+    }
+    
+    if (batch || !socketPath.empty() || !rpcAddress.empty()) {
+        // Stdout only carries replies, so only errors are shown, on stderr
+        HeadlessSink sink;
+        TodoApp app("todo_log.txt");
+        app.setOutputSink(sink);
+        if (!coldDirectory.empty() && !openColdTier(app, coldDirectory, coldAfter)) {
+            return 1;
+        }
+        if (!dataDirectory.empty() && !app.openDataDirectory(dataDirectory)) {
+            return 1;
+        }
+        std::signal(SIGPIPE, SIG_IGN);
+        if (!rpcAddress.empty()) {
+            return serveRpc(app, rpcAddress) ? 0 : 1;
+        }
+        if (!socketPath.empty()) {
+            return serveUnixSocket(app, socketPath) ? 0 : 1;
+        }
+        return CommandSession(app, STDIN_FILENO, STDOUT_FILENO).run() ? 0 : 1;
+    }
+    
+    std::cout << "=== Welcome to Interactive TODO App ===" << std::endl;
+    std::cout << "Your tasks will be logged to 'todo_log.txt'" << std::endl;
+    
+    TodoApp app("todo_log.txt");
+    if (!coldDirectory.empty() && !openColdTier(app, coldDirectory, coldAfter)) {
+        return 1;
+    }
+    if (!dataDirectory.empty()) {
+        if (!app.openDataDirectory(dataDirectory)) {
+            return 1;
+        }
+        std::cout << "Your tasks will be saved in '" << dataDirectory << "'" << std::endl;
+    }
+    int choice;
+    
+    while (true) {
+        displayMenu();
+        choice = getUserChoice();
+        
+        switch (choice) {
+            case 1:
+                handleAddTask(app);
+                break;
+            case 2:
+                handleViewTasks(app);
+                break;
+            case 3:
+                handleViewTasksByUrgency(app);
+                break;
+            case 4:
+                handleMarkCompleted(app);
+                break;
+            case 5:
+                handleRemoveTask(app);
+                break;
+            case 6:
+                app.displayStatistics();
+                break;
+            case 7:
+                handleExportTasks(app);
+                break;
+            case 8:
+                app.clearCompleted();
+                break;
+            case 9:
+                handleFilterByUrgency(app);
+                break;
+            case 10:
+                handleImportTasks(app);
+                break;
+            case 11:
+                handleSearchTasks(app);
+                break;
+            case 0:
+                std::cout << "Thank you for using TODO App! Goodbye!" << std::endl;
+                return 0;
+            default:
+                std::cout << "Invalid choice! Please select 0-11." << std::endl;
+                break;
+        }
+        
+        // Pause before showing menu again
+        std::cout << "\nPress Enter to continue...";
+        std::cin.get();
+    }
+    
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "TODO_Metrics.h"
+#include "TODO_Output.h"
+
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> nextRegistrySerial(1);
+
+const char* const kOpNames[kMetricOps] = {"add", "remove", "complete", "query", "export", "log_flush",
+                                         "log_sync"};
+
+// Prometheus bucket bounds, 1-2.5-5 per decade from 100 ns to 10 s
+const double kPrometheusBounds[] = {
+    1e-7, 2.5e-7, 5e-7, 1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+    1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+void appendDouble(OutputBuffer& out, double value) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.9g", value);
+    out.append(text, static_cast<size_t>(length));
+}
+
+void appendMetricHeader(OutputBuffer& out, const char* name, const char* type, const char* help) {
+    out.append("# HELP ").append(name).append(' ').append(help).append('\n');
+    out.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+}
+
+} // namespace
+
+std::string_view metricOpName(MetricOp op) {
+    return kOpNames[static_cast<size_t>(op)];
+}
+
+double secondsPerMetricTick() {
+#if TODO_METRICS_TSC
+    // Calibrated against steady_clock over everything since the first call
+    typedef std::chrono::steady_clock Clock;
+    static const Clock::time_point startTime = Clock::now();
+    static const uint64_t startTicks = readMetricTicks();
+    std::chrono::duration<double> elapsed = Clock::now() - startTime;
+    uint64_t ticks = readMetricTicks() - startTicks;
+    if (ticks == 0 || elapsed.count() <= 0) {
+        return 1e-9;
+    }
+    return elapsed.count() / static_cast<double>(ticks);
+#else
+    return 1e-9;
+#endif
+}
+
+// LatencyHistogram Implementation
+LatencyHistogram::LatencyHistogram() : samples(0), totalTicks(0), maxTicks(0) {
+    for (std::atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::bucketLimit(size_t bucket) {
+    if (bucket < kLatencySubBuckets) {
+        return bucket + 1;
+    }
+    size_t exponent = bucket / kLatencySubBuckets + 3;
+    uint64_t subBucket = bucket % kLatencySubBuckets;
+    return (kLatencySubBuckets + subBucket + 1) << (exponent - 4);
+}
+
+// OperationStats Implementation
+double OperationStats::percentileSeconds(double quantile) const {
+    if (samples == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(samples));
+    if (rank >= samples) rank = samples - 1;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        seen += buckets[bucket];
+        if (seen > rank) {
+            double limit = static_cast<double>(LatencyHistogram::bucketLimit(bucket)) * secondsPerTick;
+            return limit < maxSeconds ? limit : maxSeconds;
+        }
+    }
+    return maxSeconds;
+}
+
+// MetricsRegistry Implementation
+MetricsRegistry::Shard::Shard(std::thread::id thread) : owner(thread) {
+    for (size_t op = 0; op < kMetricOps; ++op) {
+        calls[op].store(0, std::memory_order_relaxed);
+        items[op].store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsRegistry::MetricsRegistry() : serial(nextRegistrySerial.fetch_add(1)) {
+    secondsPerMetricTick();   // Start the calibration before anything is timed
+}
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricsRegistry::Shard& MetricsRegistry::attachShard() {
+    std::thread::id self = std::this_thread::get_id();
+    Shard* shard = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        // A thread may come back after recording into another registry
+        for (const std::unique_ptr<Shard>& existing : shards) {
+            if (existing->owner == self) {
+                shard = existing.get();
+                break;
+            }
+        }
+        if (!shard) {
+            shards.emplace_back(new Shard(self));
+            shard = shards.back().get();
+        }
+    }
+    shardCache.serial = serial;
+    shardCache.shard = shard;
+    return *shard;
+}
+
+void MetricsRegistry::collect(MetricsSnapshot& snapshot) const {
+    double secondsPerTick = secondsPerMetricTick();
+    for (size_t op = 0; op < kMetricOps; ++op) {
+        OperationStats& stats = snapshot.operations[op];
+        stats = OperationStats();
+        stats.secondsPerTick = secondsPerTick;
+        stats.buckets.assign(kLatencyBuckets, 0);
+    }
+
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for (const std::unique_ptr<Shard>& shard : shards) {
+        for (size_t op = 0; op < kMetricOps; ++op) {
+            OperationStats& stats = snapshot.operations[op];
+            const LatencyHistogram& latency = shard->latencies[op];
+            stats.calls += shard->calls[op].load(std::memory_order_relaxed);
+            stats.items += shard->items[op].load(std::memory_order_relaxed);
+            stats.samples += latency.samples.load(std::memory_order_relaxed);
+            stats.sampledSeconds += static_cast<double>(latency.totalTicks.load(std::memory_order_relaxed)) *
+                                    secondsPerTick;
+            double maxSeconds = static_cast<double>(latency.maxTicks.load(std::memory_order_relaxed)) *
+                                secondsPerTick;
+            if (maxSeconds > stats.maxSeconds) stats.maxSeconds = maxSeconds;
+            for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+                stats.buckets[bucket] += latency.buckets[bucket].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// CountingMemoryResource Implementation
+void* CountingMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = upstream->allocate(bytes, alignment);
+    allocated.fetch_add(bytes, std::memory_order_relaxed);
+    return pointer;
+}
+
+void CountingMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream->deallocate(pointer, bytes, alignment);
+    allocated.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// Prometheus output
+void appendPrometheus(OutputBuffer& out, const MetricsSnapshot& snapshot) {
+    appendMetricHeader(out, "todo_operations_total", "counter", "Calls of each TodoApp operation.");
+    for (size_t op = 0; op < kMetricOps; ++op) {
+        out.append("todo_operations_total{op=\"").append(kOpNames[op]).append("\"} ")
+           .appendInt(static_cast<int64_t>(snapshot.operations[op].calls)).append('\n');
+    }
+
+    appendMetricHeader(out, "todo_operation_items_total", "counter",
+                       "Tasks handled by each operation; log entries for log_flush.");
+    for (size_t op = 0; op < kMetricOps; ++op) {
+        out.append("todo_operation_items_total{op=\"").append(kOpNames[op]).append("\"} ")
+           .appendInt(static_cast<int64_t>(snapshot.operations[op].items)).append('\n');
+    }
+
+    appendMetricHeader(out, "todo_operation_duration_seconds", "histogram",
+                       "Latency of a sample of the calls of each operation.");
+    for (size_t op = 0; op < kMetricOps; ++op) {
+        const OperationStats& stats = snapshot.operations[op];
+        // Fine buckets are counted under the first bound at or above their limit
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (double bound : kPrometheusBounds) {
+            while (bucket < stats.buckets.size() &&
+                   static_cast<double>(LatencyHistogram::bucketLimit(bucket)) * stats.secondsPerTick <= bound) {
+                cumulative += stats.buckets[bucket++];
+            }
+            out.append("todo_operation_duration_seconds_bucket{op=\"").append(kOpNames[op]).append("\",le=\"");
+            appendDouble(out, bound);
+            out.append("\"} ").appendInt(static_cast<int64_t>(cumulative)).append('\n');
+        }
+        out.append("todo_operation_duration_seconds_bucket{op=\"").append(kOpNames[op])
+           .append("\",le=\"+Inf\"} ").appendInt(static_cast<int64_t>(stats.samples)).append('\n');
+        out.append("todo_operation_duration_seconds_sum{op=\"").append(kOpNames[op]).append("\"} ");
+        appendDouble(out, stats.sampledSeconds);
+        out.append("\ntodo_operation_duration_seconds_count{op=\"").append(kOpNames[op]).append("\"} ")
+           .appendInt(static_cast<int64_t>(stats.samples)).append('\n');
+    }
+
+    appendMetricHeader(out, "todo_tasks", "gauge", "Tasks in memory by state.");
+    out.append("todo_tasks{state=\"pending\"} ").appendInt(static_cast<int64_t>(snapshot.pendingTasks)).append('\n');
+    out.append("todo_tasks{state=\"completed\"} ").appendInt(static_cast<int64_t>(snapshot.completedTasks)).append('\n');
+
+    appendMetricHeader(out, "todo_cold_tasks", "gauge", "Tasks in the cold tier.");
+    out.append("todo_cold_tasks ").appendInt(static_cast<int64_t>(snapshot.coldTasks)).append('\n');
+
+    appendMetricHeader(out, "todo_cold_storage_bytes", "gauge", "Size of the cold segment files.");
+    out.append("todo_cold_storage_bytes ").appendInt(static_cast<int64_t>(snapshot.coldBytes)).append('\n');
+
+    appendMetricHeader(out, "todo_storage_bytes", "gauge", "Bytes allocated for task storage and the ID index.");
+    out.append("todo_storage_bytes ").appendInt(static_cast<int64_t>(snapshot.storageBytes)).append('\n');
+
+    appendMetricHeader(out, "todo_resident_memory_bytes", "gauge", "Resident memory of the process.");
+    out.append("todo_resident_memory_bytes ").appendInt(static_cast<int64_t>(snapshot.residentBytes)).append('\n');
+}
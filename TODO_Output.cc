@@ -0,0 +1,98 @@
+#include "TODO_Output.h"
+#include "TODO_Time.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// OutputBuffer Implementation
+OutputBuffer::OutputBuffer(size_t initialCapacity)
+    : bytes(initialCapacity > 0 ? new char[initialCapacity] : nullptr),
+      capacity(initialCapacity), used(0) {}
+
+char* OutputBuffer::grow(size_t extra) {
+    size_t grown = capacity > 0 ? capacity : 4096;
+    while (grown - used < extra) grown *= 2;
+    std::unique_ptr<char[]> larger(new char[grown]);   // Left uninitialized
+    if (used > 0) {
+        std::memcpy(larger.get(), bytes.get(), used);
+    }
+    bytes.swap(larger);
+    capacity = grown;
+    return bytes.get() + used;
+}
+
+OutputBuffer& OutputBuffer::appendInt(int64_t value) {
+    const size_t maxDigits = 20;   // "-9223372036854775808"
+    char* begin = reserveExtra(maxDigits);
+    used = static_cast<size_t>(std::to_chars(begin, begin + maxDigits, value).ptr - bytes.get());
+    return *this;
+}
+
+OutputBuffer& OutputBuffer::appendTimestamp(std::chrono::system_clock::time_point time,
+                                            TimestampFormat format) {
+    used += formatTimestamp(time, format, reserveExtra(kMaxTimestampLength));
+    return *this;
+}
+
+OutputBuffer& OutputBuffer::appendRepeated(char c, size_t count) {
+    std::memset(reserveExtra(count), c, count);
+    used += count;
+    return *this;
+}
+
+// OutputFile Implementation
+OutputFile::OutputFile() : fd(-1), failed(false), staging(kFlushBytes + 64 * 1024) {}
+
+OutputFile::~OutputFile() {
+    close();
+}
+
+bool OutputFile::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    failed = fd < 0;
+    staging.clear();
+    return fd >= 0;
+}
+
+bool OutputFile::writeAll(const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void OutputFile::flush() {
+    if (fd >= 0 && !failed && !staging.empty() && !writeAll(staging.data(), staging.size())) {
+        failed = true;
+    }
+    staging.clear();
+}
+
+void OutputFile::write(const char* data, size_t length) {
+    flush();
+    if (fd >= 0 && !failed && !writeAll(data, length)) {
+        failed = true;
+    }
+}
+
+bool OutputFile::close() {
+    if (fd < 0) {
+        return false;
+    }
+    flush();
+    if (::close(fd) != 0) {
+        failed = true;
+    }
+    fd = -1;
+    return !failed;
+}
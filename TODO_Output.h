@@ -0,0 +1,168 @@
+#ifndef TODO_OUTPUT_H
+#define TODO_OUTPUT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <memory>
+
+#include "TODO_Time.h"
+
+/**
+ * @brief Growable byte buffer with allocation-free formatting helpers
+ *
+ * The exporters format every task into one of these instead of going
+ * through std::ostream. Integers are written with std::to_chars and
+ * timestamps with formatLocalTimestamp(), so once the buffer has reached
+ * its working size, appending a task allocates nothing. clear() keeps the
+ * storage for reuse.
+ */
+class OutputBuffer {
+private:
+    std::unique_ptr<char[]> bytes;   ///< Storage, only the first used bytes are valid
+    size_t capacity;                 ///< Allocated size of bytes
+    size_t used;                     ///< Number of bytes appended so far
+
+    /**
+     * @brief Reallocate so that at least extra more bytes fit
+     * @param extra Number of bytes about to be appended
+     * @return Pointer to the first free byte
+     */
+    char* grow(size_t extra);
+
+    /**
+     * @brief Make room for at least extra more bytes
+     * @param extra Number of bytes about to be appended
+     * @return Pointer to the first free byte
+     *
+     * Inline so that appends of short, constant-length pieces compile
+     * down to a capacity check and a few moves.
+     */
+    char* reserveExtra(size_t extra) {
+        return capacity - used >= extra ? bytes.get() + used : grow(extra);
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param initialCapacity Initial capacity in bytes
+     */
+    explicit OutputBuffer(size_t initialCapacity = 0);
+
+    OutputBuffer& append(const char* data, size_t length) {
+        std::memcpy(reserveExtra(length), data, length);
+        used += length;
+        return *this;
+    }
+    OutputBuffer& append(std::string_view text) { return append(text.data(), text.size()); }
+    OutputBuffer& append(char c) {
+        *reserveExtra(1) = c;
+        used++;
+        return *this;
+    }
+
+    /**
+     * @brief Append a signed integer in decimal
+     * @param value Value to append
+     * @return Reference to this buffer
+     */
+    OutputBuffer& appendInt(int64_t value);
+
+    /**
+     * @brief Append a time point as local "YYYY-MM-DD HH:MM:SS" or as epoch seconds
+     * @param time Time point to append
+     * @param format Timestamp format to write
+     * @return Reference to this buffer
+     */
+    OutputBuffer& appendTimestamp(std::chrono::system_clock::time_point time,
+                                  TimestampFormat format = TimestampFormat::LOCAL);
+
+    /**
+     * @brief Append the same character several times
+     * @param c Character to repeat
+     * @param count Number of copies
+     * @return Reference to this buffer
+     */
+    OutputBuffer& appendRepeated(char c, size_t count);
+
+    const char* data() const { return bytes.get(); }
+    char* data() { return bytes.get(); }
+    size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+
+    /**
+     * @brief Forget the contents but keep the storage
+     */
+    void clear() { used = 0; }
+};
+
+/**
+ * @brief Output file fed from an OutputBuffer with plain write() calls
+ *
+ * Bytes are staged in buffer() and handed to the kernel in large blocks
+ * by flushIfFull() and close(). A failed write is remembered and reported
+ * by close(), so the formatting loops do not need to check every call.
+ */
+class OutputFile {
+private:
+    int fd;                 ///< Open descriptor, -1 when closed
+    bool failed;            ///< Set once any write has failed
+    OutputBuffer staging;   ///< Bytes not yet written
+
+    bool writeAll(const char* data, size_t length);
+
+public:
+    static const size_t kFlushBytes = 1 << 20;   ///< Staged size that triggers a write
+
+    OutputFile();
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    /**
+     * @brief Create or truncate a file for writing
+     * @param filename Name of the file
+     * @return true if the file was opened, false otherwise
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Get the staging buffer to append to
+     * @return Reference to the staging buffer
+     */
+    OutputBuffer& buffer() { return staging; }
+
+    /**
+     * @brief Write the staged bytes once at least kFlushBytes are pending
+     */
+    void flushIfFull() {
+        if (staging.size() >= kFlushBytes) flush();
+    }
+
+    /**
+     * @brief Write all staged bytes
+     */
+    void flush();
+
+    /**
+     * @brief Write bytes after everything staged so far
+     * @param data Bytes to write
+     * @param length Number of bytes
+     *
+     * The bytes go straight to the file without being copied into the
+     * staging buffer, which suits large preformatted blocks.
+     */
+    void write(const char* data, size_t length);
+
+    /**
+     * @brief Flush and close the file
+     * @return true if every byte was written, false otherwise
+     */
+    bool close();
+};
+
+#endif // TODO_OUTPUT_H
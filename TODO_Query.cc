@@ -0,0 +1,434 @@
+#include "TODO_Query.h"
+#include "TODO_ColdStore.h"
+#include "TODO_Search.h"
+#include "TODO_Simd.h"
+
+#include <algorithm>
+
+namespace {
+
+const unsigned kAllLevels = 0xF;   // Every urgency level
+const unsigned kAllStates = 3;     // Pending and completed
+
+/**
+ * @brief Sort key of a candidate task and where to find it
+ */
+struct RankedSlot {
+    int rank;          ///< Minus the urgency level for priority order, 0 otherwise
+    int64_t created;   ///< Creation ticks, 0 for ID order
+    int id;            ///< Task ID
+    size_t slot;       ///< Slot of the task in the store, or index of a cold task
+    bool cold;         ///< Whether the task comes from the cold tier
+
+    bool operator<(const RankedSlot& other) const {
+        if (rank != other.rank) return rank < other.rank;
+        if (created != other.created) return created < other.created;
+        return id < other.id;
+    }
+};
+
+/**
+ * @brief Keeps the first rows of a query result in query order
+ *
+ * Rows that arrive presorted are appended until the limit is reached.
+ * Otherwise a max-heap holds the best rows seen so far, so memory stays
+ * bounded by the limit.
+ */
+class ResultCollector {
+private:
+    size_t limit;                   ///< Maximum number of rows
+    bool presorted;                 ///< Whether rows arrive in result order
+    std::vector<RankedSlot> rows;   ///< Rows kept, a heap unless presorted
+
+public:
+    ResultCollector(size_t maxRows, bool sorted) : limit(maxRows), presorted(sorted) {}
+
+    /**
+     * @brief Offer a row
+     * @param row Row that passed every restriction
+     * @return false once no later row can be part of the result
+     */
+    bool add(const RankedSlot& row) {
+        if (presorted || limit == std::numeric_limits<size_t>::max()) {
+            rows.push_back(row);
+            return !presorted || rows.size() < limit;
+        }
+        if (rows.size() < limit) {
+            rows.push_back(row);
+            std::push_heap(rows.begin(), rows.end());
+        } else if (row < rows.front()) {
+            std::pop_heap(rows.begin(), rows.end());
+            rows.back() = row;
+            std::push_heap(rows.begin(), rows.end());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the rows in result order
+     * @return Rows kept
+     */
+    const std::vector<RankedSlot>& finish() {
+        if (!presorted) {
+            std::sort(rows.begin(), rows.end());
+        }
+        return rows;
+    }
+};
+
+// system_clock ticks of a cold segment's creation time
+int64_t ticksOfNanoseconds(int64_t nanoseconds) {
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds(nanoseconds)).count());
+}
+
+// Bits of the 64-slot block at `block` that are live and pass the level and state filters
+uint64_t blockCandidates(const TaskStore& store, size_t block, unsigned levels, unsigned states) {
+    const TaskSegment& segment = store.segment(block / TaskStore::kSegmentSlots);
+    size_t index = block % TaskStore::kSegmentSlots;
+    size_t count = std::min<size_t>(64, store.slotCount() - block);
+    uint64_t mask = ~segment.removedBits[index / 64];
+    if (count < 64) mask &= (uint64_t(1) << count) - 1;
+    if (states == 1) mask &= ~segment.completedBits[index / 64];
+    if (states == 2) mask &= segment.completedBits[index / 64];
+    if (levels != kAllLevels && mask != 0) {
+        uint64_t levelMask = 0;
+        for (unsigned level = 0; level < 4; ++level) {
+            if (levels & (1u << level)) {
+                levelMask |= matchUrgencyBlock(segment.urgencies + index, count, static_cast<uint8_t>(level + 1));
+            }
+        }
+        mask &= levelMask;
+    }
+    return mask;
+}
+
+// Live tasks in the whole 64-slot blocks covering [begin, end) that pass the level and state filters
+size_t countBlockCandidates(const TaskStore& store, size_t begin, size_t end, unsigned levels, unsigned states) {
+    size_t total = 0;
+    // Segments hold a multiple of 64 slots, so no block straddles two
+    for (size_t block = begin & ~size_t(63), stop; block < end; block = stop) {
+        size_t segmentIndex = block / TaskStore::kSegmentSlots;
+        size_t index = block % TaskStore::kSegmentSlots;
+        size_t segmentEnd = segmentIndex * TaskStore::kSegmentSlots + store.segmentSlots(segmentIndex);
+        stop = std::min(segmentEnd, (end + 63) & ~size_t(63));
+        const TaskSegment& segment = store.segment(segmentIndex);
+        TaskStateCounts counts = countTaskStates(segment.urgencies + index, segment.completedBits + index / 64,
+                                                 segment.removedBits + index / 64, stop - block);
+        for (unsigned level = 0; level < 4; ++level) {
+            if (!(levels & (1u << level))) continue;
+            if (states & 1u) total += counts.counts[level][0];
+            if (states & 2u) total += counts.counts[level][1];
+        }
+    }
+    return total;
+}
+
+const char* accessName(QueryAccess access) {
+    switch (access) {
+        case QueryAccess::NONE: return "no access";
+        case QueryAccess::ID_RANGE: return "id range";
+        case QueryAccess::TEXT: return "text index";
+        case QueryAccess::CREATION_ORDER: return "creation order";
+        case QueryAccess::STATE_BUCKETS: return "state buckets";
+        case QueryAccess::FULL_SCAN: return "full scan";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+// TaskQuery Implementation
+TaskQuery::TaskQuery()
+    : levels(kAllLevels), states(kAllStates),
+      firstId(std::numeric_limits<int>::min()), lastId(std::numeric_limits<int>::max()),
+      fromTicks(std::numeric_limits<int64_t>::min()), toTicks(std::numeric_limits<int64_t>::max()),
+      order(QueryOrder::ID), maxRows(std::numeric_limits<size_t>::max()) {}
+
+TaskQuery& TaskQuery::urgency(Urgency level) {
+    levels &= 1u << (urgencyToInt(level) - 1);
+    return *this;
+}
+
+TaskQuery& TaskQuery::urgencyAtLeast(Urgency level) {
+    levels &= kAllLevels & ~((1u << (urgencyToInt(level) - 1)) - 1);
+    return *this;
+}
+
+TaskQuery& TaskQuery::pending() {
+    states &= 1;
+    return *this;
+}
+
+TaskQuery& TaskQuery::completed() {
+    states &= 2;
+    return *this;
+}
+
+TaskQuery& TaskQuery::idsBetween(int first, int last) {
+    firstId = std::max(firstId, first);
+    lastId = std::min(lastId, last);
+    return *this;
+}
+
+TaskQuery& TaskQuery::createdBetween(std::chrono::system_clock::time_point from,
+                                     std::chrono::system_clock::time_point to) {
+    fromTicks = std::max(fromTicks, static_cast<int64_t>(from.time_since_epoch().count()));
+    toTicks = std::min(toTicks, static_cast<int64_t>(to.time_since_epoch().count()));
+    return *this;
+}
+
+TaskQuery& TaskQuery::createdBefore(std::chrono::system_clock::time_point time) {
+    return createdBetween(std::chrono::system_clock::time_point::min(), time);
+}
+
+TaskQuery& TaskQuery::createdSince(std::chrono::system_clock::time_point time) {
+    return createdBetween(time, std::chrono::system_clock::time_point::max());
+}
+
+TaskQuery& TaskQuery::matching(const std::string& words) {
+    if (!text.empty()) text.push_back(' ');
+    text += words;
+    return *this;
+}
+
+TaskQuery& TaskQuery::orderBy(QueryOrder resultOrder) {
+    order = resultOrder;
+    return *this;
+}
+
+TaskQuery& TaskQuery::limit(size_t count) {
+    maxRows = count;
+    return *this;
+}
+
+// QueryPlan Implementation
+std::string QueryPlan::describe() const {
+    std::string text = accessName(access);
+    if (access != QueryAccess::NONE) {
+        text += ", ~" + std::to_string(estimatedRows) + " rows";
+        text += presorted ? ", presorted" : ", top-k sort";
+    }
+    return text;
+}
+
+// TodoApp query execution
+std::pair<size_t, size_t> TodoApp::slotsOfIds(int firstId, int lastId) const {
+    // Slots are in ascending ID order, tombstones included, apart from a compaction gap
+    size_t begin = partitionSlotsById(store, [firstId](int id) { return id < firstId; });
+    size_t end = partitionSlotsById(store, [lastId](int id) { return id <= lastId; });
+    return std::make_pair(begin, std::max(begin, end));
+}
+
+QueryPlan TodoApp::planQueryLocked(const TaskQuery& query, const TextQuery& text) const {
+    QueryPlan plan = {QueryAccess::NONE, 0, true};
+    if (query.levels == 0 || query.states == 0 || query.firstId > query.lastId ||
+        query.fromTicks >= query.toTicks || query.maxRows == 0 ||
+        (!text.empty() && text.matchesNothing())) {
+        return plan;
+    }
+
+    // Every candidate path with the rows it would read; on a tie the one
+    // that delivers rows in the requested order wins
+    size_t bucketRows = 0;
+    for (size_t level = 0; level < 4; ++level) {
+        for (size_t state = 0; state < 2; ++state) {
+            if ((query.levels & (1u << level)) && (query.states & (1u << state))) {
+                bucketRows += stateBuckets[level][state].size();
+            }
+        }
+    }
+    bool unfiltered = query.levels == kAllLevels && query.states == kAllStates;
+    plan.access = unfiltered ? QueryAccess::FULL_SCAN : QueryAccess::STATE_BUCKETS;
+    plan.estimatedRows = bucketRows;
+    plan.presorted = query.order == QueryOrder::ID;
+
+    auto consider = [&plan, &query](QueryAccess access, size_t rows, bool idOrder) {
+        bool presorted = idOrder ? query.order == QueryOrder::ID : query.order != QueryOrder::ID;
+        if (rows < plan.estimatedRows || (rows == plan.estimatedRows && presorted && !plan.presorted)) {
+            plan.access = access;
+            plan.estimatedRows = rows;
+            plan.presorted = presorted;
+        }
+    };
+
+    if (query.firstId != std::numeric_limits<int>::min() || query.lastId != std::numeric_limits<int>::max()) {
+        // Counting the range's live matches costs a few instructions per 64 slots
+        std::pair<size_t, size_t> slots = slotsOfIds(query.firstId, query.lastId);
+        consider(QueryAccess::ID_RANGE,
+                 countBlockCandidates(store, slots.first, slots.second, query.levels, query.states), true);
+    }
+    if (!text.empty()) {
+        consider(QueryAccess::TEXT, text.estimate(), true);
+    }
+
+    // Count the creation range only up to the best estimate so far, so
+    // planning never costs more than running the chosen plan
+    size_t creationRows = bucketRows;
+    if (query.fromTicks != std::numeric_limits<int64_t>::min() ||
+        query.toTicks != std::numeric_limits<int64_t>::max()) {
+        size_t cap = plan.estimatedRows;
+        creationRows = 0;
+        forEachKeyCreatedBetween(query.fromTicks, query.toTicks, query.levels, query.states,
+                                 [&creationRows, cap](const PriorityKey&) { return ++creationRows <= cap; });
+    }
+    consider(QueryAccess::CREATION_ORDER, creationRows, false);
+    return plan;
+}
+
+QueryPlan TodoApp::planQuery(const TaskQuery& query) const {
+    std::shared_lock<WriterPriorityMutex> state(stateMutex);
+    TextQuery text(searchIndex, query.text);
+    return planQueryLocked(query, text);
+}
+
+std::vector<Task> TodoApp::runQuery(const TaskQuery& query) const {
+    MetricsRegistry::Timer timer(registry, MetricOp::QUERY, 0);
+    std::shared_lock<WriterPriorityMutex> state(stateMutex);
+    TextQuery text(searchIndex, query.text);
+    QueryPlan plan = planQueryLocked(query, text);
+    std::vector<Task> tasks;
+    // A term missing from the search index may still occur in a cold task
+    bool scanCold = cold && !cold->segments().empty() && query.levels != 0 && query.states != 0 &&
+                    query.firstId <= query.lastId && query.fromTicks < query.toTicks && query.maxRows > 0;
+    if (plan.access == QueryAccess::NONE && !scanCold) {
+        return tasks;
+    }
+
+    // Residual restrictions read single columns; the text terms come last
+    // since probing the posting lists costs the most
+    bool probeText = !text.empty() && plan.access != QueryAccess::TEXT;
+    ResultCollector collector(query.maxRows, plan.presorted && !scanCold);
+    auto offer = [this, &query, &text, &collector, probeText](size_t slot) {
+        int id = store.id(slot);
+        int level = store.urgencyLevel(slot);
+        int64_t created = store.createdAt(slot);
+        if (id < query.firstId || id > query.lastId ||
+            !(query.levels & (1u << (level - 1))) ||
+            !(query.states & (store.completed(slot) ? 2u : 1u)) ||
+            created < query.fromTicks || created >= query.toTicks ||
+            (probeText && !text.contains(id))) {
+            return true;
+        }
+        RankedSlot row;
+        row.rank = query.order == QueryOrder::PRIORITY ? -level : 0;
+        row.created = query.order == QueryOrder::ID ? 0 : created;
+        row.id = id;
+        row.slot = slot;
+        row.cold = false;
+        return collector.add(row);
+    };
+    auto offerId = [this, &offer](int id) {
+        auto it = idIndex.find(id);
+        return it == idIndex.end() || offer(it->second);   // The text index lags removals
+    };
+
+    switch (plan.access) {
+        case QueryAccess::ID_RANGE:
+        case QueryAccess::FULL_SCAN: {
+            std::pair<size_t, size_t> slots = plan.access == QueryAccess::ID_RANGE
+                ? slotsOfIds(query.firstId, query.lastId)
+                : std::make_pair(size_t(0), store.slotCount());
+            // Tombstones and the level and state filters are applied 64 slots at a time
+            bool more = true;
+            for (size_t block = slots.first & ~size_t(63); more && block < slots.second; block += 64) {
+                uint64_t mask = blockCandidates(store, block, query.levels, query.states);
+                if (block < slots.first) mask &= ~uint64_t(0) << (slots.first - block);
+                if (slots.second - block < 64) mask &= (uint64_t(1) << (slots.second - block)) - 1;
+                for (; more && mask != 0; mask &= mask - 1) {
+                    more = offer(block + static_cast<size_t>(__builtin_ctzll(mask)));
+                }
+            }
+            break;
+        }
+        case QueryAccess::TEXT:
+            for (int id; text.next(id);) {
+                if (!offerId(id)) break;
+            }
+            break;
+        case QueryAccess::STATE_BUCKETS: {
+            // Merge the selected ID sets, which are each in ascending order
+            const OrderedIdSet* sets[8];
+            OrderedIdSet::const_iterator next[8];
+            size_t count = 0;
+            for (size_t level = 0; level < 4; ++level) {
+                for (size_t state = 0; state < 2; ++state) {
+                    if ((query.levels & (1u << level)) && (query.states & (1u << state))) {
+                        sets[count] = &stateBuckets[level][state];
+                        next[count] = sets[count]->begin();
+                        count++;
+                    }
+                }
+            }
+            while (true) {
+                size_t lowest = count;
+                for (size_t i = 0; i < count; ++i) {
+                    if (next[i] != sets[i]->end() && (lowest == count || *next[i] < *next[lowest])) {
+                        lowest = i;
+                    }
+                }
+                if (lowest == count || !offerId(*next[lowest])) break;
+                ++next[lowest];
+            }
+            break;
+        }
+        case QueryAccess::CREATION_ORDER: {
+            auto offerKey = [&offerId](const PriorityKey& key) { return offerId(key.id); };
+            if (query.order == QueryOrder::PRIORITY) {
+                // One urgency level at a time, CRITICAL first, stopping with the limit
+                bool more = true;
+                for (size_t level = 4; more && level-- > 0;) {
+                    if (!(query.levels & (1u << level))) continue;
+                    forEachKeyCreatedBetween(query.fromTicks, query.toTicks, 1u << level, query.states,
+                                             [&offerKey, &more](const PriorityKey& key) {
+                                                 return more = offerKey(key);
+                                             });
+                }
+            } else {
+                forEachKeyCreatedBetween(query.fromTicks, query.toTicks, query.levels, query.states, offerKey);
+            }
+            break;
+        }
+        case QueryAccess::NONE:
+            break;
+    }
+
+    // Cold tasks have no indexes but segments outside the ID and creation ranges are skipped
+    std::vector<TaskRef> coldTasks;
+    if (scanCold) {
+        ColdSet candidates = cold->segments().select([&query](const ColdSegment& segment) {
+            return segment.maxId() >= query.firstId && segment.minId() <= query.lastId &&
+                   ticksOfNanoseconds(segment.maxCreatedAtNs()) >= query.fromTicks &&
+                   ticksOfNanoseconds(segment.minCreatedAtNs()) < query.toTicks;
+        });
+        TermMatcher words(query.text);
+        ColdSet::Reader reader(candidates, query.firstId);
+        for (ColdTask coldTask; reader.read(coldTask) && coldTask.id <= query.lastId;) {
+            TaskRef task = coldTaskRef(coldTask);
+            int level = urgencyToInt(task.urgency);
+            int64_t created = static_cast<int64_t>(task.createdAt.time_since_epoch().count());
+            if (!(query.levels & (1u << (level - 1))) ||
+                !(query.states & (task.completed ? 2u : 1u)) ||
+                created < query.fromTicks || created >= query.toTicks ||
+                idIndex.count(task.id) > 0 || (!words.empty() && !words.matches(task.description))) {
+                continue;
+            }
+            RankedSlot row;
+            row.rank = query.order == QueryOrder::PRIORITY ? -level : 0;
+            row.created = query.order == QueryOrder::ID ? 0 : created;
+            row.id = task.id;
+            row.slot = coldTasks.size();
+            row.cold = true;
+            coldTasks.push_back(task);
+            collector.add(row);
+        }
+    }
+
+    const std::vector<RankedSlot>& rows = collector.finish();
+    tasks.reserve(rows.size());
+    for (const RankedSlot& row : rows) {
+        tasks.push_back(row.cold ? coldTasks[row.slot].toTask() : taskAt(row.slot).toTask());
+    }
+    timer.setItems(tasks.size());
+    return tasks;
+}
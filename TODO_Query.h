@@ -0,0 +1,151 @@
+#ifndef TODO_QUERY_H
+#define TODO_QUERY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "TODO_App.h"
+
+/**
+ * @brief Order of the tasks returned by TodoApp::runQuery()
+ */
+enum class QueryOrder {
+    ID,        ///< Ascending ID, which is insertion order
+    CREATED,   ///< Oldest first, ties broken by ID
+    PRIORITY   ///< Task::operator<: highest urgency first, then oldest, then ID
+};
+
+/**
+ * @brief Index a query plan reads its candidate tasks from
+ */
+enum class QueryAccess {
+    NONE,             ///< The query cannot match anything; nothing is read
+    ID_RANGE,         ///< The slots of an ID range, found by binary search
+    TEXT,             ///< The intersected posting lists of the search terms
+    CREATION_ORDER,   ///< The priority sets, seeked to the creation time range
+    STATE_BUCKETS,    ///< The ID sets of the selected urgency levels and states
+    FULL_SCAN         ///< Every slot of the store
+};
+
+/**
+ * @brief Builder for a combined task query
+ *
+ * Every restriction narrows the query further, so calls can be chained
+ * in any order. A default-constructed query matches every task in ID
+ * order.
+ *
+ * @par Example:
+ * @code
+ * auto weekAgo = std::chrono::system_clock::now() - std::chrono::hours(24 * 7);
+ * std::vector<Task> tasks = app.runQuery(TaskQuery().pending()
+ *                                                   .urgency(Urgency::CRITICAL)
+ *                                                   .matching("deploy")
+ *                                                   .createdSince(weekAgo)
+ *                                                   .orderBy(QueryOrder::CREATED)
+ *                                                   .limit(20));
+ * @endcode
+ */
+class TaskQuery {
+private:
+    friend class TodoApp;
+
+    unsigned levels;      ///< Bit i set: urgency level i + 1 matches
+    unsigned states;      ///< Bit 0: pending tasks match, bit 1: completed tasks match
+    int firstId;          ///< Smallest matching ID
+    int lastId;           ///< Largest matching ID
+    int64_t fromTicks;    ///< Earliest matching creation time, system_clock ticks
+    int64_t toTicks;      ///< Creation time matching tasks were created before
+    std::string text;     ///< Search terms, as for TodoApp::searchTasks()
+    QueryOrder order;     ///< Order of the results
+    size_t maxRows;       ///< Maximum number of results
+
+public:
+    TaskQuery();
+
+    /**
+     * @brief Only match tasks of one urgency level
+     * @param level Urgency level
+     */
+    TaskQuery& urgency(Urgency level);
+
+    /**
+     * @brief Only match tasks of an urgency level or a higher one
+     * @param level Lowest urgency level
+     */
+    TaskQuery& urgencyAtLeast(Urgency level);
+
+    /**
+     * @brief Only match tasks that are not completed
+     */
+    TaskQuery& pending();
+
+    /**
+     * @brief Only match completed tasks
+     */
+    TaskQuery& completed();
+
+    /**
+     * @brief Only match tasks with IDs in a range
+     * @param first Smallest ID to match
+     * @param last Largest ID to match
+     */
+    TaskQuery& idsBetween(int first, int last);
+
+    /**
+     * @brief Only match tasks created in a time range
+     * @param from Earliest creation time to match
+     * @param to Creation time to stop before
+     */
+    TaskQuery& createdBetween(std::chrono::system_clock::time_point from,
+                              std::chrono::system_clock::time_point to);
+
+    /**
+     * @brief Only match tasks created before a point in time
+     * @param time Creation time to stop before
+     */
+    TaskQuery& createdBefore(std::chrono::system_clock::time_point time);
+
+    /**
+     * @brief Only match tasks created at or after a point in time
+     * @param time Earliest creation time to match
+     */
+    TaskQuery& createdSince(std::chrono::system_clock::time_point time);
+
+    /**
+     * @brief Only match tasks whose descriptions contain every given word
+     * @param words Words as for TodoApp::searchTasks(), '*' suffixes included
+     */
+    TaskQuery& matching(const std::string& words);
+
+    /**
+     * @brief Set the order of the results
+     * @param resultOrder Order to return the tasks in (default: ID)
+     */
+    TaskQuery& orderBy(QueryOrder resultOrder);
+
+    /**
+     * @brief Return at most a number of tasks
+     * @param count Maximum number of tasks, the first ones in the query order
+     */
+    TaskQuery& limit(size_t count);
+};
+
+/**
+ * @brief How TodoApp::runQuery() answers a query
+ */
+struct QueryPlan {
+    QueryAccess access;      ///< Index the candidates are read from
+    size_t estimatedRows;    ///< Upper bound for the candidates read
+    bool presorted;          ///< Whether candidates arrive in result order, so a limit stops early
+
+    /**
+     * @brief Describe the plan in one line, e.g. for logging
+     * @return Text such as "text index, ~120 rows, top-k sort"
+     */
+    std::string describe() const;
+};
+
+#endif // TODO_QUERY_H
@@ -0,0 +1,366 @@
+#include "TODO_Search.h"
+
+#include <algorithm>
+
+namespace {
+
+bool isTermByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/**
+ * @brief Split text into lowercased terms
+ * @param text Text to split
+ * @param term Buffer that holds the current term while func runs
+ * @param func Called with term and whether a '*' follows it, once per term
+ */
+template <typename Func>
+void forEachTerm(std::string_view text, std::string& term, Func func) {
+    size_t position = 0;
+    while (position < text.size()) {
+        while (position < text.size() && !isTermByte(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+        term.clear();
+        while (position < text.size() && isTermByte(static_cast<unsigned char>(text[position]))) {
+            char c = text[position++];
+            term.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+        if (!term.empty()) {
+            func(term, position < text.size() && text[position] == '*');
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Position in a posting list that moves forward only
+ */
+class TextQuery::PostingCursor {
+private:
+    const PostingList* list;   ///< List being read
+    size_t block;              ///< Block of the current ID
+    uint32_t index;            ///< Position of the current ID in the list
+    uint32_t offset;           ///< Offset of the next gap in list->bytes
+    int current;               ///< Current ID
+
+    void enterBlock(size_t blockIndex) {
+        block = blockIndex;
+        index = static_cast<uint32_t>(blockIndex) * PostingList::kBlockSize;
+        offset = list->skips[blockIndex].offset;
+        current = list->skips[blockIndex].firstId;
+    }
+
+public:
+    explicit PostingCursor(const PostingList& postings)
+        : list(&postings), block(0), index(0), offset(0), current(0) {
+        if (postings.count > 0) enterBlock(0);
+    }
+
+    bool atEnd() const { return index >= list->count; }
+    int id() const { return current; }
+
+    /**
+     * @brief Move to the next ID
+     */
+    void next() {
+        if (++index >= list->count) {
+            return;
+        }
+        if (index % PostingList::kBlockSize == 0) {
+            enterBlock(block + 1);
+            return;
+        }
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = list->bytes[offset++];
+            gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        current += static_cast<int>(gap);
+    }
+
+    /**
+     * @brief Move to the first ID not less than target
+     * @param target ID to look for
+     */
+    void seek(int target) {
+        if (atEnd() || current >= target) {
+            return;
+        }
+        // Jump over whole blocks that end before target
+        if (block + 1 < list->skips.size() && list->skips[block + 1].firstId <= target) {
+            auto later = std::upper_bound(list->skips.begin() + block + 1, list->skips.end(), target,
+                [](int value, const PostingList::Skip& skip) { return value < skip.firstId; });
+            enterBlock(static_cast<size_t>(later - list->skips.begin()) - 1);
+        }
+        while (!atEnd() && current < target) {
+            next();
+        }
+    }
+};
+
+/**
+ * @brief One query term: the union of the posting lists it matches
+ *
+ * A plain term matches one list, a prefix term every list of a term
+ * that starts with it.
+ */
+class TextQuery::TermCursor {
+private:
+    std::vector<const PostingList*> sources;   ///< Every list of the term
+    std::vector<PostingCursor> lists;          ///< Lists that have not ended yet
+    int current;                               ///< Smallest ID across lists
+
+    void settle() {
+        lists.erase(std::remove_if(lists.begin(), lists.end(),
+                                   [](const PostingCursor& list) { return list.atEnd(); }),
+                    lists.end());
+        if (lists.empty()) return;
+        current = lists[0].id();
+        for (const PostingCursor& list : lists) {
+            current = std::min(current, list.id());
+        }
+    }
+
+public:
+    size_t estimate;   ///< Total IDs in the lists, to order the intersection
+
+    TermCursor() : current(0), estimate(0) {}
+
+    void add(const PostingList& postings) {
+        sources.push_back(&postings);
+        estimate += postings.count;
+    }
+
+    /**
+     * @brief Move every list back to its first ID
+     */
+    void start() {
+        lists.clear();
+        for (const PostingList* postings : sources) {
+            lists.emplace_back(*postings);
+        }
+        settle();
+    }
+
+    bool atEnd() const { return lists.empty(); }
+    int id() const { return current; }
+
+    void next() {
+        for (PostingCursor& list : lists) {
+            if (list.id() == current) list.next();
+        }
+        settle();
+    }
+
+    void seek(int target) {
+        if (atEnd() || current >= target) {
+            return;
+        }
+        for (PostingCursor& list : lists) {
+            list.seek(target);
+        }
+        settle();
+    }
+};
+
+// PostingList Implementation
+void PostingList::append(int id) {
+    if (count % kBlockSize == 0) {
+        skips.push_back(Skip{id, static_cast<uint32_t>(bytes.size())});
+    } else {
+        uint32_t gap = static_cast<uint32_t>(id - lastId);
+        while (gap >= 0x80) {
+            bytes.push_back(static_cast<uint8_t>(gap | 0x80));
+            gap >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(gap));
+    }
+    lastId = id;
+    count++;
+}
+
+// TextIndex Implementation
+void TextIndex::add(int id, std::string_view text) {
+    indexedTasks++;
+    forEachTerm(text, scratch, [this, id](const std::string& term, bool) {
+        auto it = terms.find(term);
+        if (it == terms.end()) {
+            // Nodes never move, so the ordered map can point into them
+            it = terms.emplace(term, PostingList()).first;
+            termOrder.emplace(std::string_view(it->first), &it->second);
+        }
+        // A term that occurs twice in one description is listed once
+        if (it->second.count == 0 || it->second.lastId != id) {
+            it->second.append(id);
+        }
+    });
+}
+
+void TextIndex::prune(const std::function<bool(int)>& isLive) {
+    for (auto it = terms.begin(); it != terms.end();) {
+        PostingList& list = it->second;
+        liveIds.clear();
+        for (TextQuery::PostingCursor cursor(list); !cursor.atEnd(); cursor.next()) {
+            if (isLive(cursor.id())) liveIds.push_back(cursor.id());
+        }
+        if (liveIds.empty()) {
+            termOrder.erase(std::string_view(it->first));
+            it = terms.erase(it);
+            continue;
+        }
+
+        // Rewrite the list in its own storage, so churn does not reallocate
+        list.bytes.clear();
+        list.skips.clear();
+        list.count = 0;
+        for (int id : liveIds) {
+            list.append(id);
+        }
+        if (list.bytes.capacity() > 4 * list.bytes.size() + 4096) {
+            list.bytes.shrink_to_fit();
+            list.skips.shrink_to_fit();
+        }
+        ++it;
+    }
+    indexedTasks -= removedTasks;
+    removedTasks = 0;
+}
+
+void TextIndex::search(std::string_view query, const std::function<bool(int)>& visit) const {
+    TextQuery matches(*this, query);
+    for (int id; matches.next(id);) {
+        if (!visit(id)) {
+            return;
+        }
+    }
+}
+
+void TextIndex::clear() {
+    termOrder.clear();
+    std::unordered_map<std::string, PostingList>().swap(terms);
+    indexedTasks = 0;
+    removedTasks = 0;
+}
+
+// TextQuery Implementation
+TextQuery::TextQuery(const TextIndex& index, std::string_view query)
+    : missing(false), started(false), advance(false), lastProbe(0) {
+    std::string term;
+    forEachTerm(query, term, [this, &index](const std::string& word, bool prefix) {
+        cursors.emplace_back();
+        TermCursor& cursor = cursors.back();
+        if (prefix) {
+            std::string_view start(word);
+            for (auto it = index.termOrder.lower_bound(start);
+                 it != index.termOrder.end() && it->first.substr(0, start.size()) == start; ++it) {
+                cursor.add(*it->second);
+            }
+        } else {
+            auto it = index.terms.find(word);
+            if (it != index.terms.end()) cursor.add(it->second);
+        }
+        missing = missing || cursor.estimate == 0;
+    });
+
+    // Drive the intersection from the rarest term; the others only seek
+    std::sort(cursors.begin(), cursors.end(),
+              [](const TermCursor& a, const TermCursor& b) { return a.estimate < b.estimate; });
+}
+
+TextQuery::~TextQuery() {}
+
+void TextQuery::start() {
+    for (TermCursor& cursor : cursors) {
+        cursor.start();
+    }
+    started = true;
+    advance = false;
+    lastProbe = 0;
+}
+
+size_t TextQuery::estimate() const {
+    return matchesNothing() ? 0 : cursors[0].estimate;
+}
+
+bool TextQuery::next(int& id) {
+    if (matchesNothing()) {
+        return false;
+    }
+    if (!started) {
+        start();
+    } else if (advance) {
+        cursors[0].next();
+    }
+    advance = false;
+
+    TermCursor& lead = cursors[0];
+    while (!lead.atEnd()) {
+        int candidate = lead.id();
+        bool matched = true;
+        for (size_t i = 1; i < cursors.size(); ++i) {
+            cursors[i].seek(candidate);
+            if (cursors[i].atEnd()) {
+                return false;
+            }
+            if (cursors[i].id() != candidate) {
+                lead.seek(cursors[i].id());
+                matched = false;
+                break;
+            }
+        }
+        if (matched) {
+            id = candidate;
+            advance = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TextQuery::contains(int id) {
+    if (matchesNothing()) {
+        return false;
+    }
+    if (!started || id < lastProbe) {
+        start();
+    }
+    lastProbe = id;
+    for (TermCursor& cursor : cursors) {
+        cursor.seek(id);
+        if (cursor.atEnd() || cursor.id() != id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// TermMatcher Implementation
+TermMatcher::TermMatcher(std::string_view query) {
+    std::string term;
+    forEachTerm(query, term, [this](const std::string& word, bool prefix) {
+        terms.push_back(Term{word, prefix});
+    });
+}
+
+bool TermMatcher::matches(std::string_view text) const {
+    if (terms.empty()) {
+        return false;
+    }
+    found.assign(terms.size(), false);
+    size_t missing = terms.size();
+    forEachTerm(text, scratch, [this, &missing](const std::string& word, bool) {
+        for (size_t i = 0; i < terms.size(); ++i) {
+            const Term& term = terms[i];
+            if (found[i]) continue;
+            bool hit = term.prefix ? word.compare(0, term.text.size(), term.text) == 0 : word == term.text;
+            if (hit) {
+                found[i] = true;
+                missing--;
+            }
+        }
+    });
+    return missing == 0;
+}
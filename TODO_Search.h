@@ -0,0 +1,237 @@
+#ifndef TODO_SEARCH_H
+#define TODO_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Sorted task IDs of one search term, delta-compressed
+ *
+ * IDs are grouped in blocks of kBlockSize. The first ID of each block is
+ * kept uncompressed in the skip list together with the block's byte
+ * offset; the other IDs are stored as varint gaps to their predecessor.
+ * A search can therefore jump to the block that may hold an ID with a
+ * binary search and only decode that block.
+ */
+struct PostingList {
+    static const uint32_t kBlockSize = 128;   ///< IDs per block
+
+    /**
+     * @brief Start of one block
+     */
+    struct Skip {
+        int firstId;       ///< First ID of the block
+        uint32_t offset;   ///< Offset of the block's gaps in bytes
+    };
+
+    std::vector<uint8_t> bytes;   ///< Varint gaps of every block, back to back
+    std::vector<Skip> skips;      ///< One entry per block
+    int lastId = 0;               ///< Largest ID in the list
+    uint32_t count = 0;           ///< Number of IDs in the list
+
+    /**
+     * @brief Append an ID larger than every ID in the list
+     * @param id ID to append
+     */
+    void append(int id);
+};
+
+/**
+ * @brief Inverted index from description words to task IDs
+ *
+ * Descriptions are split into terms: runs of letters and digits, with
+ * ASCII letters lowercased. Bytes of multi-byte UTF-8 characters count
+ * as letters, so non-English words are indexed as they are written.
+ * Every term maps to the PostingList of the tasks that contain it,
+ * through a hash table for exact terms and an ordered map, which only
+ * changes when a new term appears, for prefixes.
+ *
+ * Tasks must be added in ascending ID order, which is the order TodoApp
+ * creates them in, so adding is an append to a few posting lists.
+ * Removal does not touch the posting lists: search results are checked
+ * against the live tasks by the caller, and prune() drops the IDs of
+ * removed tasks once they make up half of the index.
+ */
+class TextIndex {
+private:
+    friend class TextQuery;
+
+    std::unordered_map<std::string, PostingList> terms;          ///< Posting list of every term
+    std::map<std::string_view, const PostingList*> termOrder;    ///< Same lists by term, for prefix queries
+    std::string scratch;                                         ///< Reused buffer for lowercased terms
+    std::vector<int> liveIds;                                    ///< Reused buffer for prune()
+    size_t indexedTasks;                                         ///< Tasks added since the last prune
+    size_t removedTasks;                                         ///< Of those, tasks removed since
+
+public:
+    TextIndex() : indexedTasks(0), removedTasks(0) {}
+
+    /**
+     * @brief Index the description of a new task
+     * @param id Task ID, greater than every ID added before
+     * @param text Description of the task
+     */
+    void add(int id, std::string_view text);
+
+    /**
+     * @brief Record that indexed tasks were removed
+     * @param count Number of removed tasks
+     */
+    void markRemoved(size_t count) { removedTasks += count; }
+
+    /**
+     * @brief Check whether removed tasks make up half of the index
+     * @return true if prune() is due
+     */
+    bool needsPrune() const { return removedTasks * 2 > indexedTasks && removedTasks >= 1024; }
+
+    /**
+     * @brief Drop the IDs of removed tasks from every posting list
+     * @param isLive Returns whether a task ID is still in use
+     */
+    void prune(const std::function<bool(int)>& isLive);
+
+    /**
+     * @brief Find the tasks whose descriptions contain every query term
+     * @param query Terms separated by anything but letters and digits;
+     *              a term directly followed by '*' matches every term
+     *              that starts with it
+     * @param visit Called with each matching ID in ascending order,
+     *              returns false to stop the search
+     *
+     * Matching is case-insensitive for ASCII letters. Visits the IDs of
+     * removed tasks too until they are pruned. A query without terms
+     * matches nothing.
+     */
+    void search(std::string_view query, const std::function<bool(int)>& visit) const;
+
+    /**
+     * @brief Get the number of distinct terms
+     * @return Term count
+     */
+    size_t termCount() const { return terms.size(); }
+
+    /**
+     * @brief Remove every term and release the storage
+     */
+    void clear();
+};
+
+/**
+ * @brief A parsed search query bound to a TextIndex
+ *
+ * Query terms follow the rules of TextIndex::search(). The matches can
+ * either be listed with next() or tested one ID at a time with
+ * contains(), which lets a caller that already has candidate IDs from
+ * another index intersect them with the posting lists without listing
+ * every match. Use one of the two on a query, not both. Invalidated by
+ * any change to the index.
+ */
+class TextQuery {
+private:
+    friend class TextIndex;
+    class PostingCursor;
+    class TermCursor;
+
+    std::vector<TermCursor> cursors;   ///< One per query term, rarest first
+    bool missing;                      ///< Whether some term matches no task
+    bool started;                      ///< Whether the cursors were positioned
+    bool advance;                      ///< Whether next() must step past the last match
+    int lastProbe;                     ///< ID of the last contains() call
+
+    void start();
+
+public:
+    /**
+     * @brief Parse a query and look up its terms
+     * @param index Index to search
+     * @param query Query text
+     */
+    TextQuery(const TextIndex& index, std::string_view query);
+    ~TextQuery();
+
+    TextQuery(const TextQuery&) = delete;
+    TextQuery& operator=(const TextQuery&) = delete;
+
+    /**
+     * @brief Check whether the query has any terms
+     * @return true if the query text held no letters or digits
+     */
+    bool empty() const { return cursors.empty(); }
+
+    /**
+     * @brief Check whether the query cannot match any task
+     * @return true if it has no terms or a term that occurs nowhere
+     */
+    bool matchesNothing() const { return cursors.empty() || missing; }
+
+    /**
+     * @brief Get an upper bound for the number of matches
+     * @return Number of IDs listed for the rarest term
+     */
+    size_t estimate() const;
+
+    /**
+     * @brief Get the next matching ID
+     * @param id Receives the ID, in ascending order across calls
+     * @return false once every match was returned
+     */
+    bool next(int& id);
+
+    /**
+     * @brief Check whether a task ID matches every term
+     * @param id ID to test
+     * @return true if the task's description contained every term when indexed
+     *
+     * Cheapest when called with ascending IDs, since the cursors then only
+     * move forward; a smaller ID restarts them.
+     */
+    bool contains(int id);
+};
+
+/**
+ * @brief Search query that is matched against description text directly
+ *
+ * Follows the term rules of TextIndex::search(), for tasks that are not
+ * in a TextIndex, such as the cold tier. Each call of matches() splits
+ * the text into terms, so it costs a scan of the description.
+ */
+class TermMatcher {
+private:
+    struct Term {
+        std::string text;   ///< Lowercased query term
+        bool prefix;        ///< Whether the term ends in '*'
+    };
+
+    std::vector<Term> terms;           ///< Every term of the query
+    mutable std::string scratch;       ///< Reused buffer for the terms of the text
+    mutable std::vector<bool> found;   ///< Reused flags of the terms seen so far
+
+public:
+    /**
+     * @brief Parse a query
+     * @param query Query text, as for TextIndex::search()
+     */
+    explicit TermMatcher(std::string_view query);
+
+    /**
+     * @brief Check whether the query has any terms
+     * @return true if the query text held no letters or digits
+     */
+    bool empty() const { return terms.empty(); }
+
+    /**
+     * @brief Check whether a text contains every query term
+     * @param text Description to test
+     * @return true if every term occurs in it; false for a query without terms
+     */
+    bool matches(std::string_view text) const;
+};
+
+#endif // TODO_SEARCH_H
@@ -0,0 +1,560 @@
+#include "TODO_Server.h"
+#include "TODO_Output.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+const size_t kFrameHeaderBytes = 4 + 1 + 4;   // Length, type, tag
+const size_t kReadBytes = 64 * 1024;          // Bytes requested per read()
+const size_t kReadLimit = 256 * 1024;         // Bytes read from one connection per wakeup
+const size_t kMaxPendingOutput = 8 << 20;     // Unsent bytes that pause reading
+const size_t kMaxListBytes = 16 << 20;        // Response size that truncates a listing
+const int kMaxEvents = 256;                   // Events handled per epoll_wait()
+const size_t kMaxHttpHeaderBytes = 8 * 1024;  // Largest HTTP request head accepted
+
+void putU32(OutputBuffer& out, uint32_t value) {
+    char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                     static_cast<char>(value >> 16), static_cast<char>(value >> 24)};
+    out.append(bytes, sizeof(bytes));
+}
+
+void putU64(OutputBuffer& out, uint64_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+    putU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+void patchU32(OutputBuffer& out, size_t offset, uint32_t value) {
+    char* at = out.data() + offset;
+    for (int i = 0; i < 4; ++i) {
+        at[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+uint32_t getU32(const char* in) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(in);
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+/**
+ * @brief Start a response frame
+ * @return Offset of its length field, for finishResponse()
+ */
+size_t beginResponse(OutputBuffer& out, RpcStatus status, uint32_t tag) {
+    size_t start = out.size();
+    putU32(out, 0);
+    out.append(static_cast<char>(status));
+    putU32(out, tag);
+    return start;
+}
+
+void finishResponse(OutputBuffer& out, size_t start) {
+    patchU32(out, start, static_cast<uint32_t>(out.size() - start - 4));
+}
+
+void putResponse(OutputBuffer& out, RpcStatus status, uint32_t tag) {
+    finishResponse(out, beginResponse(out, status, tag));
+}
+
+void putTask(OutputBuffer& out, const TaskRef& task) {
+    putU32(out, static_cast<uint32_t>(task.id));
+    out.append(static_cast<char>(urgencyToInt(task.urgency)));
+    out.append(static_cast<char>(task.completed ? 1 : 0));
+    putU64(out, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        task.createdAt.time_since_epoch()).count()));
+    putU32(out, static_cast<uint32_t>(task.description.size()));
+    out.append(task.description);
+}
+
+/**
+ * @brief State of one client connection
+ */
+struct Connection {
+    int fd;                               ///< Non-blocking client socket
+    std::string input;                    ///< Received bytes not yet decoded
+    OutputBuffer output;                  ///< Encoded responses
+    size_t written = 0;                   ///< Bytes of output already sent
+    bool peerClosed = false;              ///< Whether the client finished sending
+    uint32_t events = 0;                  ///< Events registered with epoll
+
+    RpcOp runOp = RpcOp::PING;            ///< Type of the pending mutations, PING for none
+    std::vector<NewTask> runTasks;        ///< Tasks of a pending ADD_TASK run
+    std::vector<int> runIds;              ///< IDs of a pending COMPLETE_TASK or REMOVE_TASK run
+    std::vector<uint32_t> runTags;        ///< Tags of the pending mutations
+
+    explicit Connection(int socket) : fd(socket), output(kReadBytes) {}
+    ~Connection() { close(fd); }
+
+    size_t unsent() const { return output.size() - written; }
+};
+
+/**
+ * @brief Apply the pending mutations of a connection and respond to each
+ */
+void flushRun(TodoApp& app, Connection& connection) {
+    RpcOp op = connection.runOp;
+    connection.runOp = RpcOp::PING;
+    if (connection.runTags.empty()) {
+        return;
+    }
+    OutputBuffer& out = connection.output;
+
+    if (op == RpcOp::ADD_TASK) {
+        BatchResult result = app.addTasks(connection.runTasks);
+        for (size_t i = 0; i < connection.runTags.size(); ++i) {
+            size_t start = beginResponse(out, result.committed ? RpcStatus::OK : RpcStatus::FAILED,
+                                         connection.runTags[i]);
+            if (result.committed) putU32(out, static_cast<uint32_t>(result.ids[i]));
+            finishResponse(out, start);
+        }
+    } else {
+        const std::vector<int>& ids = connection.runIds;
+        BatchResult result = op == RpcOp::COMPLETE_TASK ? app.markCompletedBatch(ids) : app.removeTasks(ids);
+        std::sort(result.notFound.begin(), result.notFound.end());
+        std::sort(result.archived.begin(), result.archived.end());
+        // A task can only be removed once; later requests for it in the run did not find it
+        std::vector<bool> answered(op == RpcOp::REMOVE_TASK ? result.ids.size() : 0);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (result.committed && std::binary_search(result.archived.begin(), result.archived.end(), ids[i])) {
+                putResponse(out, RpcStatus::ARCHIVED, connection.runTags[i]);
+                continue;
+            }
+            bool found = !std::binary_search(result.notFound.begin(), result.notFound.end(), ids[i]);
+            if (found && op == RpcOp::REMOVE_TASK) {
+                auto it = std::lower_bound(result.ids.begin(), result.ids.end(), ids[i]);
+                size_t position = static_cast<size_t>(it - result.ids.begin());
+                found = it != result.ids.end() && *it == ids[i] && !answered[position];
+                if (found) answered[position] = true;
+            }
+            RpcStatus status = !result.committed ? RpcStatus::FAILED : found ? RpcStatus::OK : RpcStatus::NOT_FOUND;
+            putResponse(out, status, connection.runTags[i]);
+        }
+    }
+    connection.runTasks.clear();
+    connection.runIds.clear();
+    connection.runTags.clear();
+}
+
+/**
+ * @brief Respond to a LIST_TASKS request
+ */
+void listTasks(TodoApp& app, Connection& connection, uint32_t tag, unsigned level, unsigned state,
+               uint32_t limit) {
+    OutputBuffer& out = connection.output;
+    size_t start = beginResponse(out, RpcStatus::OK, tag);
+    size_t countAt = out.size();
+    putU32(out, 0);
+    out.append('\0');
+
+    uint32_t count = 0;
+    bool truncated = false;
+    auto visit = [&](const TaskRef& task) {
+        if (state != 0 && task.completed != (state == 2)) return true;
+        if (limit != 0 && count == limit) return false;
+        if (out.size() - start > kMaxListBytes) {
+            truncated = true;
+            return false;
+        }
+        putTask(out, task);
+        count++;
+        return true;
+    };
+
+    if (level == 0 && state == 0) {
+        // Every task: a snapshot iterates the columns in ID order without holding the lock
+        TaskSnapshot tasks = app.snapshot();
+        for (const TaskRef& task : tasks) {
+            if (!visit(task)) break;
+        }
+    } else {
+        auto lock = app.readLock();
+        TaskView view = level != 0 ? app.viewTasksByUrgency(intToUrgency(static_cast<int>(level)))
+                      : state == 1 ? app.viewPendingTasks() : app.viewCompletedTasks();
+        for (const TaskRef& task : view) {
+            if (!visit(task)) break;
+        }
+    }
+    patchU32(out, countAt, count);
+    out.data()[countAt + 4] = truncated ? 1 : 0;
+    finishResponse(out, start);
+}
+
+/**
+ * @brief Handle one request frame
+ */
+void handleRequest(TodoApp& app, Connection& connection, RpcOp op, uint32_t tag, std::string_view payload) {
+    OutputBuffer& out = connection.output;
+
+    // Mutations join the run of their type; anything else ends the run first
+    if (op == RpcOp::ADD_TASK) {
+        int level = payload.empty() ? 0 : static_cast<unsigned char>(payload[0]);
+        if (level < 1 || level > 4 || payload.size() < 2) {
+            flushRun(app, connection);
+            putResponse(out, RpcStatus::BAD_REQUEST, tag);
+            return;
+        }
+        if (connection.runOp != op) flushRun(app, connection);
+        connection.runOp = op;
+        connection.runTasks.push_back(NewTask{std::string(payload.substr(1)), intToUrgency(level)});
+        connection.runTags.push_back(tag);
+        return;
+    }
+    if (op == RpcOp::COMPLETE_TASK || op == RpcOp::REMOVE_TASK) {
+        if (payload.size() != 4) {
+            flushRun(app, connection);
+            putResponse(out, RpcStatus::BAD_REQUEST, tag);
+            return;
+        }
+        if (connection.runOp != op) flushRun(app, connection);
+        connection.runOp = op;
+        connection.runIds.push_back(static_cast<int>(getU32(payload.data())));
+        connection.runTags.push_back(tag);
+        return;
+    }
+    flushRun(app, connection);
+
+    switch (op) {
+        case RpcOp::PING:
+            putResponse(out, RpcStatus::OK, tag);
+            return;
+        case RpcOp::GET_TASK: {
+            if (payload.size() != 4) break;
+            size_t start = beginResponse(out, RpcStatus::OK, tag);
+            bool found = app.visitTaskById(static_cast<int>(getU32(payload.data())),
+                                           [&out](const TaskRef& task) { putTask(out, task); });
+            if (!found) out.data()[start + 4] = static_cast<char>(RpcStatus::NOT_FOUND);
+            finishResponse(out, start);
+            return;
+        }
+        case RpcOp::LIST_TASKS: {
+            unsigned level = payload.size() == 6 ? static_cast<unsigned char>(payload[0]) : 5;
+            unsigned state = payload.size() == 6 ? static_cast<unsigned char>(payload[1]) : 3;
+            if (level > 4 || state > 2) break;
+            listTasks(app, connection, tag, level, state, getU32(payload.data() + 2));
+            return;
+        }
+        case RpcOp::GET_METRICS: {
+            if (!payload.empty()) break;
+            size_t start = beginResponse(out, RpcStatus::OK, tag);
+            appendPrometheus(out, app.metrics());
+            finishResponse(out, start);
+            return;
+        }
+        case RpcOp::GET_STATS: {
+            if (!payload.empty()) break;
+            uint32_t levels[4];
+            uint32_t pending;
+            {
+                auto lock = app.readLock();
+                for (int i = 0; i < 4; ++i) {
+                    levels[i] = static_cast<uint32_t>(app.viewTasksByUrgency(intToUrgency(i + 1)).size());
+                }
+                pending = static_cast<uint32_t>(app.viewPendingTasks().size());
+            }
+            uint32_t total = levels[0] + levels[1] + levels[2] + levels[3];
+            size_t start = beginResponse(out, RpcStatus::OK, tag);
+            putU32(out, total);
+            putU32(out, pending);
+            putU32(out, total - pending);
+            for (uint32_t count : levels) {
+                putU32(out, count);
+            }
+            finishResponse(out, start);
+            return;
+        }
+        default:
+            break;
+    }
+    putResponse(out, RpcStatus::BAD_REQUEST, tag);
+}
+
+/**
+ * @brief Answer an HTTP request for the metrics once its head has arrived
+ * @return false if the connection must be closed
+ */
+bool serviceHttp(TodoApp& app, Connection& connection) {
+    const std::string& input = connection.input;
+    size_t headEnd = input.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        return input.size() <= kMaxHttpHeaderBytes && !connection.peerClosed;
+    }
+    std::string_view requestLine(input.data(), input.find("\r\n"));
+    std::string_view target = requestLine.substr(4, requestLine.find(' ', 4) - 4);
+
+    OutputBuffer body(16 * 1024);
+    const char* status = "404 Not Found";
+    if (target == "/metrics" || target.substr(0, 9) == "/metrics?") {
+        status = "200 OK";
+        appendPrometheus(body, app.metrics());
+    } else {
+        body.append("Not found; metrics are served at /metrics\n");
+    }
+
+    OutputBuffer& out = connection.output;
+    out.append("HTTP/1.1 ").append(status).append("\r\n");
+    out.append("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    out.append("Content-Length: ").appendInt(static_cast<int64_t>(body.size())).append("\r\n");
+    out.append("Connection: close\r\n\r\n");
+    out.append(body.data(), body.size());
+    connection.input.clear();
+    connection.peerClosed = true;   // One request per connection; close once the response is sent
+    return true;
+}
+
+/**
+ * @brief Read what a connection sent and respond to every complete request
+ * @return false if the connection must be closed
+ */
+bool serviceInput(TodoApp& app, Connection& connection) {
+    size_t received = 0;
+    while (received < kReadLimit) {
+        std::string& input = connection.input;
+        size_t used = input.size();
+        input.resize(used + kReadBytes);
+        ssize_t count = read(connection.fd, &input[used], kReadBytes);
+        input.resize(used + (count > 0 ? static_cast<size_t>(count) : 0));
+        if (count == 0) {
+            connection.peerClosed = true;
+            break;
+        }
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        received += static_cast<size_t>(count);
+    }
+
+    const std::string& input = connection.input;
+    // "GET " read as a length is far above kMaxFrameBytes, so this never hides a frame
+    if (input.size() >= 4 && input.compare(0, 4, "GET ") == 0) {
+        return serviceHttp(app, connection);
+    }
+    size_t offset = 0;
+    while (input.size() - offset >= 4) {
+        uint32_t length = getU32(input.data() + offset);
+        if (length < kFrameHeaderBytes - 4 || length > RpcServer::kMaxFrameBytes) {
+            return false;   // Not a frame of this protocol; nothing after it can be trusted
+        }
+        if (input.size() - offset - 4 < length) {
+            break;
+        }
+        const char* frame = input.data() + offset + 4;
+        handleRequest(app, connection, static_cast<RpcOp>(frame[0]), getU32(frame + 1),
+                      std::string_view(frame + 5, length - 5));
+        offset += 4 + length;
+    }
+    flushRun(app, connection);
+    connection.input.erase(0, offset);
+    return true;
+}
+
+/**
+ * @brief Send as much pending output as the socket takes
+ * @return false if the connection must be closed
+ */
+bool serviceOutput(Connection& connection) {
+    while (connection.unsent() > 0) {
+        ssize_t count = send(connection.fd, connection.output.data() + connection.written,
+                             connection.unsent(), MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.written += static_cast<size_t>(count);
+    }
+    connection.output.clear();
+    connection.written = 0;
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief One event loop with its listener and connections
+ */
+class RpcServer::Loop {
+public:
+    int epollFd = -1;     ///< epoll instance
+    int listener = -1;    ///< Listening socket, shared port with the other loops
+    int wakeFd = -1;      ///< eventfd written by stop()
+    bool accepting = false;   ///< Whether the listener is registered
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;   ///< Open connections by socket
+
+    ~Loop() {
+        connections.clear();
+        if (listener >= 0) close(listener);
+        if (wakeFd >= 0) close(wakeFd);
+        if (epollFd >= 0) close(epollFd);
+    }
+
+    void setAccepting(bool enable) {
+        if (enable == accepting) return;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listener;
+        epoll_ctl(epollFd, enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, listener, &event);
+        accepting = enable;
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EMFILE || errno == ENFILE) {
+                    // Out of descriptors: stop accepting until a connection closes
+                    setAccepting(false);
+                }
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;
+            }
+            int enable = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = client;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &event) != 0) {
+                close(client);
+                continue;
+            }
+            auto connection = std::make_unique<Connection>(client);
+            connection->events = EPOLLIN;
+            connections.emplace(client, std::move(connection));
+        }
+    }
+
+    void closeConnection(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        connections.erase(fd);
+        setAccepting(true);
+    }
+
+    void serviceConnection(TodoApp& app, Connection& connection, uint32_t ready) {
+        bool healthy = (ready & EPOLLERR) == 0;
+        if (healthy && (ready & (EPOLLIN | EPOLLHUP)) && !connection.peerClosed) {
+            healthy = serviceInput(app, connection);
+        }
+        healthy = healthy && serviceOutput(connection);
+        if (!healthy || (connection.peerClosed && connection.unsent() == 0)) {
+            closeConnection(connection.fd);
+            return;
+        }
+
+        // Stop reading from a client that does not read its responses
+        uint32_t wanted = 0;
+        if (!connection.peerClosed && connection.unsent() < kMaxPendingOutput) wanted |= EPOLLIN;
+        if (connection.unsent() > 0) wanted |= EPOLLOUT;
+        if (wanted != connection.events) {
+            epoll_event event{};
+            event.events = wanted;
+            event.data.fd = connection.fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.events = wanted;
+        }
+    }
+
+    void run(TodoApp& app) {
+        epoll_event events[kMaxEvents];
+        while (true) {
+            int count = epoll_wait(epollFd, events, kMaxEvents, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    return;
+                } else if (fd == listener) {
+                    acceptConnections();
+                } else {
+                    auto it = connections.find(fd);
+                    if (it != connections.end()) serviceConnection(app, *it->second, events[i].events);
+                }
+            }
+        }
+    }
+};
+
+// RpcServer Implementation
+RpcServer::RpcServer(TodoApp& todoApp, size_t threads)
+    : app(todoApp), threadCount(threads), boundPort(0) {
+    if (threadCount == 0) {
+        threadCount = std::min<size_t>(std::max(4u, std::thread::hardware_concurrency()), 8);
+    }
+}
+
+RpcServer::~RpcServer() {
+    stop();
+}
+
+bool RpcServer::start(const std::string& host, uint16_t port) {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        std::cout << "Error: '" << host << "' is not an IPv4 address!" << std::endl;
+        return false;
+    }
+
+    boundPort = port;
+    for (size_t i = 0; i < threadCount; ++i) {
+        auto loop = std::make_unique<Loop>();
+        loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        loop->listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int enable = 1;
+        address.sin_port = htons(boundPort);
+        bool ready = loop->epollFd >= 0 && loop->wakeFd >= 0 && loop->listener >= 0 &&
+                     setsockopt(loop->listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == 0 &&
+                     setsockopt(loop->listener, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == 0 &&
+                     bind(loop->listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+                     listen(loop->listener, SOMAXCONN) == 0;
+        if (ready && boundPort == 0) {
+            // Bind the other loops to the port the system picked for the first
+            socklen_t length = sizeof(address);
+            ready = getsockname(loop->listener, reinterpret_cast<sockaddr*>(&address), &length) == 0;
+            boundPort = ntohs(address.sin_port);
+        }
+        if (!ready) {
+            std::cout << "Error: Could not listen on " << host << ":" << port << ": "
+                      << std::strerror(errno) << std::endl;
+            loops.clear();
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = loop->wakeFd;
+        epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &event);
+        loop->setAccepting(true);
+        loops.push_back(std::move(loop));
+    }
+
+    for (auto& loop : loops) {
+        Loop* owned = loop.get();
+        workers.emplace_back([this, owned] { owned->run(app); });
+    }
+    return true;
+}
+
+void RpcServer::stop() {
+    for (auto& loop : loops) {
+        uint64_t one = 1;
+        (void)!write(loop->wakeFd, &one, sizeof(one));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    loops.clear();
+}
@@ -0,0 +1,128 @@
+#ifndef TODO_SERVER_H
+#define TODO_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TODO_App.h"
+
+/**
+ * @brief Request types of the binary RPC protocol
+ *
+ * Every message is a frame: a 4-byte length counting the bytes after it,
+ * then a 1-byte type, a 4-byte tag and the payload. All integers are
+ * little-endian. Requests carry an RpcOp as type and any tag; the
+ * response repeats the tag and carries an RpcStatus as type. Responses
+ * come in request order, so a client may send any number of requests
+ * before reading.
+ *
+ * A task in a payload is: int32 ID, uint8 urgency (1-4), uint8 completed,
+ * int64 creation time in nanoseconds since the Unix epoch, uint32
+ * description length and the description bytes.
+ *
+ * The numeric values are part of the wire format and must never change.
+ */
+enum class RpcOp : uint8_t {
+    PING = 1,            ///< Empty payload; empty response
+    ADD_TASK = 2,        ///< uint8 urgency, then the description; responds with the int32 ID
+    COMPLETE_TASK = 3,   ///< int32 ID; empty response
+    REMOVE_TASK = 4,     ///< int32 ID; empty response
+    GET_TASK = 5,        ///< int32 ID; responds with the task
+    LIST_TASKS = 6,      ///< uint8 urgency (0: any), uint8 state (0: any, 1: pending, 2: completed),
+                         ///< uint32 limit (0: none); responds with uint32 count, uint8 truncated
+                         ///< and the tasks in ID order
+    GET_STATS = 7,       ///< Empty payload; responds with uint32 total, pending, completed and
+                         ///< the task count of each urgency level, LOW to CRITICAL
+    GET_METRICS = 8      ///< Empty payload; responds with TodoApp::metrics() in the Prometheus
+                         ///< text format
+};
+
+/**
+ * @brief Outcome of an RPC request, sent as the type of its response
+ */
+enum class RpcStatus : uint8_t {
+    OK = 0,            ///< The request succeeded
+    NOT_FOUND = 1,     ///< No task has the requested ID
+    BAD_REQUEST = 2,   ///< Unknown type or malformed payload
+    FAILED = 3,        ///< The write-ahead log could not be written; nothing changed
+    ARCHIVED = 4       ///< The task is in the read-only cold tier and was left unchanged
+};
+
+/**
+ * @brief Event-loop server exposing a TodoApp over the RPC protocol
+ *
+ * Each worker thread runs its own epoll loop with its own listening TCP
+ * socket on the same port (SO_REUSEPORT), so the kernel spreads new
+ * connections across the loops and no lock is shared between them.
+ * Sockets are non-blocking and one loop serves thousands of connections.
+ *
+ * Everything a connection sends in one read is decoded before anything
+ * is written back. Consecutive ADD_TASK, COMPLETE_TASK or REMOVE_TASK
+ * requests are applied with one batch call, one lock round and one WAL
+ * record; reads are answered under the read lock or from a snapshot and
+ * encoded straight from the stored columns into the connection's output
+ * buffer without copying tasks. A connection that stops reading its
+ * responses is not read from until it catches up.
+ *
+ * A connection that opens with "GET " is an HTTP/1.x request instead,
+ * which no frame can start with: GET /metrics answers with
+ * TodoApp::metrics() in the Prometheus text format, so a Prometheus
+ * server can scrape the RPC port directly. The connection closes after
+ * the one response.
+ */
+class RpcServer {
+private:
+    class Loop;
+
+    TodoApp& app;                               ///< Application shared by every connection
+    size_t threadCount;                         ///< Number of event loops
+    uint16_t boundPort;                         ///< Port the listeners are bound to
+    std::vector<std::unique_ptr<Loop>> loops;   ///< One per worker thread
+    std::vector<std::thread> workers;           ///< Threads running the loops
+
+public:
+    static const uint32_t kMaxFrameBytes = 1 << 20;   ///< Largest request accepted, excluding the length
+
+    /**
+     * @brief Constructor
+     * @param todoApp Application to serve
+     * @param threads Number of event loops, 0 for one per CPU core, at least 4
+     *                and at most 8, since a loop waits while its writes commit
+     */
+    explicit RpcServer(TodoApp& todoApp, size_t threads = 0);
+
+    /**
+     * @brief Destructor, stops the server
+     */
+    ~RpcServer();
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+
+    /**
+     * @brief Bind the listeners and start the event loops
+     * @param host IPv4 address to listen on, e.g. "127.0.0.1" or "0.0.0.0"
+     * @param port TCP port, 0 to let the system pick one
+     * @return true if the server is running, false otherwise
+     */
+    bool start(const std::string& host, uint16_t port);
+
+    /**
+     * @brief Get the port the server listens on
+     * @return Bound port, useful after start() with port 0
+     */
+    uint16_t port() const { return boundPort; }
+
+    /**
+     * @brief Close every connection and stop the event loops
+     *
+     * Waits for the loops to finish. Safe to call more than once.
+     */
+    void stop();
+};
+
+#endif // TODO_SERVER_H
@@ -0,0 +1,55 @@
+#ifndef TODO_SHARED_MUTEX_H
+#define TODO_SHARED_MUTEX_H
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+/**
+ * @brief Reader-writer mutex that does not let readers starve writers
+ *
+ * std::shared_mutex on glibc prefers readers: while readers keep
+ * overlapping, a writer never gets in. Here a waiting writer raises a
+ * flag and holds a gate mutex; readers that see the flag queue on the
+ * gate instead of joining the readers already inside, so the writer gets
+ * the lock as soon as those finish. While no writer waits, a reader pays
+ * one extra atomic load.
+ *
+ * Meets the SharedMutex requirements, so it works with std::unique_lock
+ * and std::shared_lock.
+ */
+class WriterPriorityMutex {
+private:
+    std::shared_mutex mutex;              ///< The underlying reader-writer lock
+    std::mutex gate;                      ///< Held by a writer while it waits for mutex
+    std::atomic<int> waitingWriters;      ///< Writers waiting for or taking the lock
+
+public:
+    WriterPriorityMutex() : waitingWriters(0) {}
+
+    WriterPriorityMutex(const WriterPriorityMutex&) = delete;
+    WriterPriorityMutex& operator=(const WriterPriorityMutex&) = delete;
+
+    void lock() {
+        waitingWriters.fetch_add(1);
+        gate.lock();
+        mutex.lock();
+        gate.unlock();
+        waitingWriters.fetch_sub(1);
+    }
+
+    bool try_lock() { return mutex.try_lock(); }
+    void unlock() { mutex.unlock(); }
+
+    void lock_shared() {
+        if (waitingWriters.load() > 0) {
+            std::lock_guard<std::mutex> behindWriter(gate);   // Let the writer go first
+        }
+        mutex.lock_shared();
+    }
+
+    bool try_lock_shared() { return waitingWriters.load() == 0 && mutex.try_lock_shared(); }
+    void unlock_shared() { mutex.unlock_shared(); }
+};
+
+#endif // TODO_SHARED_MUTEX_H
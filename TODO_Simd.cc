@@ -0,0 +1,197 @@
+#include "TODO_Simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TODO_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define TODO_SIMD_NEON 1
+#endif
+
+namespace {
+
+uint64_t matchScalar(const uint8_t* block, size_t count, uint8_t level) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        mask |= static_cast<uint64_t>(block[i] == level) << i;
+    }
+    return mask;
+}
+
+// Add the live slots of one block to the counts, given its match masks
+inline void accumulateBlock(const uint64_t masks[4], uint64_t completed, uint64_t live,
+                            TaskStateCounts& result) {
+    for (int level = 0; level < 4; ++level) {
+        uint64_t match = masks[level] & live;
+        result.counts[level][1] += static_cast<size_t>(__builtin_popcountll(match & completed));
+        result.counts[level][0] += static_cast<size_t>(__builtin_popcountll(match & ~completed));
+    }
+}
+
+uint64_t liveMask(const uint64_t* removedWords, size_t word, size_t count) {
+    uint64_t valid = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+    return ~removedWords[word] & valid;
+}
+
+TaskStateCounts countScalar(const uint8_t* urgencies, const uint64_t* completedWords,
+                            const uint64_t* removedWords, size_t slotCount) {
+    TaskStateCounts result = {};
+    for (size_t base = 0, word = 0; base < slotCount; base += 64, ++word) {
+        size_t count = slotCount - base < 64 ? slotCount - base : 64;
+        uint64_t masks[4];
+        for (int level = 0; level < 4; ++level) {
+            masks[level] = matchScalar(urgencies + base, count, static_cast<uint8_t>(level + 1));
+        }
+        accumulateBlock(masks, completedWords[word], liveMask(removedWords, word, count), result);
+    }
+    return result;
+}
+
+#if TODO_SIMD_X86
+
+__attribute__((target("avx2")))
+uint64_t matchAvx2(const uint8_t* block, uint8_t level) {
+    __m256i needle = _mm256_set1_epi8(static_cast<char>(level));
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    uint32_t lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+    uint32_t highMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+    return (static_cast<uint64_t>(highMask) << 32) | lowMask;
+}
+
+__attribute__((target("avx2,popcnt")))
+TaskStateCounts countAvx2(const uint8_t* urgencies, const uint64_t* completedWords,
+                          const uint64_t* removedWords, size_t slotCount) {
+    TaskStateCounts result = {};
+    size_t fullBlocks = slotCount / 64;
+    for (size_t word = 0; word < fullBlocks; ++word) {
+        const uint8_t* block = urgencies + word * 64;
+        uint64_t masks[4];
+        for (int level = 0; level < 4; ++level) {
+            masks[level] = matchAvx2(block, static_cast<uint8_t>(level + 1));
+        }
+        accumulateBlock(masks, completedWords[word], ~removedWords[word], result);
+    }
+
+    size_t tail = slotCount - fullBlocks * 64;
+    if (tail > 0) {
+        uint64_t masks[4];
+        for (int level = 0; level < 4; ++level) {
+            masks[level] = matchScalar(urgencies + fullBlocks * 64, tail, static_cast<uint8_t>(level + 1));
+        }
+        accumulateBlock(masks, completedWords[fullBlocks], liveMask(removedWords, fullBlocks, tail),
+                        result);
+    }
+    return result;
+}
+
+#endif // TODO_SIMD_X86
+
+#if TODO_SIMD_NEON
+
+uint64_t matchNeon(const uint8_t* block, uint8_t level) {
+    // Narrow each 16-byte compare result to 4 bits per lane, then keep one bit per lane
+    uint8x16_t needle = vdupq_n_u8(level);
+    uint64_t mask = 0;
+    for (int part = 0; part < 4; ++part) {
+        uint8x16_t equal = vceqq_u8(vld1q_u8(block + part * 16), needle);
+        uint64_t nibbles = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+        uint64_t bits = 0;
+        for (int lane = 0; lane < 16; ++lane) {
+            bits |= ((nibbles >> (lane * 4)) & 1u) << lane;
+        }
+        mask |= bits << (part * 16);
+    }
+    return mask;
+}
+
+TaskStateCounts countNeon(const uint8_t* urgencies, const uint64_t* completedWords,
+                          const uint64_t* removedWords, size_t slotCount) {
+    TaskStateCounts result = {};
+    size_t fullBlocks = slotCount / 64;
+    for (size_t word = 0; word < fullBlocks; ++word) {
+        const uint8_t* block = urgencies + word * 64;
+        uint64_t masks[4];
+        for (int level = 0; level < 4; ++level) {
+            masks[level] = matchNeon(block, static_cast<uint8_t>(level + 1));
+        }
+        accumulateBlock(masks, completedWords[word], ~removedWords[word], result);
+    }
+
+    size_t tail = slotCount - fullBlocks * 64;
+    if (tail > 0) {
+        uint64_t masks[4];
+        for (int level = 0; level < 4; ++level) {
+            masks[level] = matchScalar(urgencies + fullBlocks * 64, tail, static_cast<uint8_t>(level + 1));
+        }
+        accumulateBlock(masks, completedWords[fullBlocks], liveMask(removedWords, fullBlocks, tail),
+                        result);
+    }
+    return result;
+}
+
+#endif // TODO_SIMD_NEON
+
+enum class Kernel { SCALAR, AVX2, NEON };
+
+Kernel detectKernel() {
+#if TODO_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return Kernel::AVX2;
+    }
+#elif TODO_SIMD_NEON
+    return Kernel::NEON;   // Always present on AArch64
+#endif
+    return Kernel::SCALAR;
+}
+
+const Kernel detectedKernel = detectKernel();
+bool scalarForced = false;
+
+Kernel activeKernel() {
+    return scalarForced ? Kernel::SCALAR : detectedKernel;
+}
+
+} // namespace
+
+TaskStateCounts countTaskStates(const uint8_t* urgencies, const uint64_t* completedWords,
+                                const uint64_t* removedWords, size_t slotCount) {
+    switch (activeKernel()) {
+#if TODO_SIMD_X86
+        case Kernel::AVX2: return countAvx2(urgencies, completedWords, removedWords, slotCount);
+#endif
+#if TODO_SIMD_NEON
+        case Kernel::NEON: return countNeon(urgencies, completedWords, removedWords, slotCount);
+#endif
+        default: return countScalar(urgencies, completedWords, removedWords, slotCount);
+    }
+}
+
+uint64_t matchUrgencyBlock(const uint8_t* block, size_t count, uint8_t level) {
+    if (count == 64) {
+        switch (activeKernel()) {
+#if TODO_SIMD_X86
+            case Kernel::AVX2: return matchAvx2(block, level);
+#endif
+#if TODO_SIMD_NEON
+            case Kernel::NEON: return matchNeon(block, level);
+#endif
+            default: break;
+        }
+    }
+    return matchScalar(block, count, level);
+}
+
+const char* activeSimdKernel() {
+    switch (activeKernel()) {
+        case Kernel::AVX2: return "avx2";
+        case Kernel::NEON: return "neon";
+        default: return "scalar";
+    }
+}
+
+void forceScalarKernels(bool force) {
+    scalarForced = force;
+}
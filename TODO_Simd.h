@@ -0,0 +1,55 @@
+#ifndef TODO_SIMD_H
+#define TODO_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Live task counts by urgency level and completion state
+ *
+ * counts[level - 1][0] holds the pending and counts[level - 1][1] the
+ * completed tasks of urgency level 1-4.
+ */
+struct TaskStateCounts {
+    size_t counts[4][2];
+};
+
+/**
+ * @brief Count live tasks by urgency and completion state from raw columns
+ * @param urgencies Urgency level (1-4) of every slot
+ * @param completedWords Completion bitset, 64 slots per word
+ * @param removedWords Tombstone bitset, 64 slots per word
+ * @param slotCount Number of slots
+ * @return Counts of the slots that are not tombstoned
+ *
+ * Works on TaskStore's columns 64 slots at a time: the urgency bytes of
+ * a block are compared against each level to get a 64-bit match mask,
+ * which is combined with the bitsets and popcounted. The comparison uses
+ * AVX2 or NEON when the CPU has it, chosen once at runtime, and plain
+ * C++ otherwise. Every variant returns identical results.
+ */
+TaskStateCounts countTaskStates(const uint8_t* urgencies, const uint64_t* completedWords,
+                                const uint64_t* removedWords, size_t slotCount);
+
+/**
+ * @brief Compute the urgency match mask of one block of up to 64 slots
+ * @param block Urgency bytes of the block
+ * @param count Number of slots in the block, at most 64
+ * @param level Urgency level to match
+ * @return Bit i set if block[i] == level
+ */
+uint64_t matchUrgencyBlock(const uint8_t* block, size_t count, uint8_t level);
+
+/**
+ * @brief Get the name of the kernel variant in use
+ * @return "avx2", "neon" or "scalar"
+ */
+const char* activeSimdKernel();
+
+/**
+ * @brief Force the plain C++ kernels, for benchmarking and testing
+ * @param force true to bypass AVX2/NEON, false to restore detection
+ */
+void forceScalarKernels(bool force);
+
+#endif // TODO_SIMD_H
@@ -0,0 +1,217 @@
+#include "TODO_Snapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kSnapshotMagic[8] = {'T', 'O', 'D', 'O', 'S', 'N', 'A', 'P'};
+const size_t kFlushBytes = 1 << 20;   // Flush a section buffer once it reaches 1 MiB
+
+} // namespace
+
+bool pwriteAll(int fd, const char* data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool commitFile(int fd, const void* header, size_t headerSize, bool ok,
+                const std::string& tempName, const std::string& targetName) {
+    if (ok && !pwriteAll(fd, static_cast<const char*>(header), headerSize, 0)) ok = false;
+    if (ok && ::fsync(fd) != 0) ok = false;
+
+    ::close(fd);
+    if (!ok || std::rename(tempName.c_str(), targetName.c_str()) != 0) {
+        ::unlink(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool isSnapshotFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char magic[sizeof(kSnapshotMagic)];
+    ssize_t got = ::read(fd, magic, sizeof(magic));
+    ::close(fd);
+    return got == static_cast<ssize_t>(sizeof(magic)) &&
+           std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+}
+
+// SnapshotWriter Implementation
+SnapshotWriter::SnapshotWriter(const std::string& filename, uint64_t taskCount, int nextId,
+                               uint64_t walSequence)
+    : targetName(filename), tempName(filename + ".tmp"), fd(-1), failed(false),
+      recordsWritten(0), recordFileOffset(0), heapFileOffset(0) {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.recordSize = sizeof(SnapshotRecord);
+    header.taskCount = taskCount;
+    header.recordsOffset = sizeof(SnapshotHeader);
+    header.heapOffset = header.recordsOffset + taskCount * sizeof(SnapshotRecord);
+    header.nextId = nextId;
+    header.walSequence = walSequence;
+
+    recordFileOffset = header.recordsOffset;
+    heapFileOffset = header.heapOffset;
+    recordBuffer.reserve(kFlushBytes + sizeof(SnapshotRecord));
+    heapBuffer.reserve(kFlushBytes);
+
+    fd = ::open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    failed = fd < 0;
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (fd >= 0) {
+        ::close(fd);
+        ::unlink(tempName.c_str());
+    }
+}
+
+void SnapshotWriter::flushBuffer(std::string& buffer, uint64_t& offset) {
+    if (!failed && !pwriteAll(fd, buffer.data(), buffer.size(), offset)) {
+        failed = true;
+    }
+    offset += buffer.size();
+    buffer.clear();
+}
+
+void SnapshotWriter::add(int id, const char* description, size_t length, uint8_t urgency,
+                         int64_t createdAtNs, bool completed) {
+    if (failed) return;
+
+    SnapshotRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.createdAtNs = createdAtNs;
+    record.descOffset = header.heapSize;
+    record.descLength = static_cast<uint32_t>(length);
+    record.id = id;
+    record.urgency = urgency;
+    record.completed = completed ? 1 : 0;
+    recordBuffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    recordsWritten++;
+
+    if (length >= kFlushBytes) {
+        // Very long descriptions bypass the heap buffer
+        flushBuffer(heapBuffer, heapFileOffset);
+        if (!failed && !pwriteAll(fd, description, length, heapFileOffset)) failed = true;
+        heapFileOffset += length;
+    } else {
+        heapBuffer.append(description, length);
+    }
+    header.heapSize += length;
+
+    if (recordBuffer.size() >= kFlushBytes) flushBuffer(recordBuffer, recordFileOffset);
+    if (heapBuffer.size() >= kFlushBytes) flushBuffer(heapBuffer, heapFileOffset);
+}
+
+bool SnapshotWriter::finish() {
+    if (fd < 0) return false;
+    if (recordsWritten != header.taskCount) failed = true;
+
+    flushBuffer(recordBuffer, recordFileOffset);
+    flushBuffer(heapBuffer, heapFileOffset);
+    int file = fd;
+    fd = -1;
+    return commitFile(file, &header, sizeof(header), !failed, tempName, targetName);
+}
+
+// SnapshotFile Implementation
+SnapshotFile::SnapshotFile()
+    : base(nullptr), mappedSize(0), header(nullptr), records(nullptr), heap(nullptr) {}
+
+SnapshotFile::~SnapshotFile() {
+    close();
+}
+
+void SnapshotFile::close() {
+    if (base) {
+        ::munmap(const_cast<char*>(base), mappedSize);
+    }
+    base = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+    records = nullptr;
+    heap = nullptr;
+}
+
+bool SnapshotFile::open(const std::string& filename) {
+    close();
+    errorMessage.clear();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        errorMessage = "could not open " + filename;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        errorMessage = filename + " is too small to be a snapshot";
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        errorMessage = "could not map " + filename;
+        return false;
+    }
+    ::madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    base = static_cast<const char*>(mapping);
+    mappedSize = fileSize;
+
+    const SnapshotHeader* candidate = reinterpret_cast<const SnapshotHeader*>(base);
+    if (std::memcmp(candidate->magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        errorMessage = filename + " is not a task snapshot";
+    } else if (candidate->byteOrder != kSnapshotByteOrder) {
+        errorMessage = filename + " was written with a different byte order";
+    } else if (candidate->version != kSnapshotVersion ||
+               candidate->headerSize != sizeof(SnapshotHeader) ||
+               candidate->recordSize != sizeof(SnapshotRecord)) {
+        errorMessage = filename + " uses unsupported snapshot version " +
+                       std::to_string(candidate->version);
+    } else if (candidate->recordsOffset > fileSize ||
+               candidate->taskCount > (fileSize - candidate->recordsOffset) / sizeof(SnapshotRecord) ||
+               candidate->heapOffset > fileSize ||
+               candidate->heapSize > fileSize - candidate->heapOffset) {
+        errorMessage = filename + " is truncated";
+    } else {
+        header = candidate;
+        records = reinterpret_cast<const SnapshotRecord*>(base + header->recordsOffset);
+        heap = base + header->heapOffset;
+        for (size_t i = 0; i < header->taskCount; ++i) {
+            const SnapshotRecord& rec = records[i];
+            if (rec.descOffset > header->heapSize ||
+                rec.descLength > header->heapSize - rec.descOffset ||
+                rec.urgency < 1 || rec.urgency > 4) {
+                errorMessage = filename + " has a corrupt record at position " + std::to_string(i);
+                break;
+            }
+        }
+    }
+
+    if (!errorMessage.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
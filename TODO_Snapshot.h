@@ -0,0 +1,240 @@
+#ifndef TODO_SNAPSHOT_H
+#define TODO_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief On-disk header of a binary task snapshot
+ *
+ * A snapshot file is laid out as the header, followed by taskCount
+ * fixed-size SnapshotRecord entries in ascending ID order, followed by a
+ * string heap holding every description back to back (not terminated).
+ * All integers are stored in host byte order; the byteOrder field lets
+ * a reader reject files written on a machine with the other endianness.
+ */
+struct SnapshotHeader {
+    char magic[8];            ///< Always "TODOSNAP"
+    uint32_t version;         ///< Format version (currently 1)
+    uint32_t byteOrder;       ///< kSnapshotByteOrder as written by the producer
+    uint32_t headerSize;      ///< sizeof(SnapshotHeader)
+    uint32_t recordSize;      ///< sizeof(SnapshotRecord)
+    uint64_t taskCount;       ///< Number of records
+    uint64_t recordsOffset;   ///< File offset of the first record
+    uint64_t heapOffset;      ///< File offset of the description heap
+    uint64_t heapSize;        ///< Size of the description heap in bytes
+    int32_t nextId;           ///< Next available task ID at the time of the snapshot
+    uint32_t reserved0;       ///< Reserved, written as zero
+    uint64_t walSequence;     ///< Last write-ahead log sequence included (0 if none)
+    uint64_t reserved1;       ///< Reserved, written as zero
+};
+
+/**
+ * @brief On-disk representation of a single task in a snapshot
+ */
+struct SnapshotRecord {
+    int64_t createdAtNs;      ///< Creation time in nanoseconds since the Unix epoch
+    uint64_t descOffset;      ///< Offset of the description within the string heap
+    uint32_t descLength;      ///< Length of the description in bytes
+    int32_t id;               ///< Task identifier
+    uint8_t urgency;          ///< Urgency level (1-4)
+    uint8_t completed;        ///< 1 if the task is completed, 0 otherwise
+    uint8_t reserved[6];      ///< Reserved, written as zero
+};
+
+static_assert(sizeof(SnapshotHeader) == 80, "SnapshotHeader layout must stay fixed");
+static_assert(sizeof(SnapshotRecord) == 32, "SnapshotRecord layout must stay fixed");
+
+const uint32_t kSnapshotVersion = 1;             ///< Current snapshot format version
+const uint32_t kSnapshotByteOrder = 0x01020304;  ///< Byte order marker
+
+/**
+ * @brief Check whether a file starts with the snapshot magic
+ * @param filename Name of the file to inspect
+ * @return true if the file looks like a binary snapshot
+ */
+bool isSnapshotFile(const std::string& filename);
+
+/**
+ * @brief Write a whole buffer at an offset, retrying on partial writes
+ * @param fd File descriptor open for writing
+ * @param data Bytes to write
+ * @param length Number of bytes
+ * @param offset File offset of the first byte
+ * @return true if every byte was written
+ */
+bool pwriteAll(int fd, const char* data, size_t length, uint64_t offset);
+
+/**
+ * @brief Finish a file written under a temporary name and put it in place
+ * @param fd Descriptor of the temporary file, closed by the call
+ * @param header Header written at offset 0, last so a torn file never looks valid
+ * @param headerSize Size of the header
+ * @param ok false if an earlier write failed, to just discard the file
+ * @param tempName Name of the temporary file
+ * @param targetName Name the file is renamed to
+ * @return true if the header was written, the file fsynced and renamed;
+ *         otherwise the temporary file is removed
+ *
+ * Shared by SnapshotWriter and ColdSegmentWriter. The caller syncs the
+ * directory when the rename itself must survive a crash.
+ */
+bool commitFile(int fd, const void* header, size_t headerSize, bool ok,
+                const std::string& tempName, const std::string& targetName);
+
+/**
+ * @brief Streaming writer for binary snapshots
+ *
+ * Records and descriptions are buffered separately and written to their
+ * final positions with pwrite(), so the snapshot is produced in a single
+ * pass without holding the whole file in memory. The data is written to
+ * a temporary file that is fsynced and renamed over the target only when
+ * finish() succeeds, so readers never observe a partial snapshot.
+ */
+class SnapshotWriter {
+private:
+    std::string targetName;   ///< Final snapshot file name
+    std::string tempName;     ///< Temporary file name used while writing
+    int fd;                   ///< Descriptor of the temporary file
+    bool failed;              ///< Set once any write has failed
+    SnapshotHeader header;    ///< Header written by finish()
+    uint64_t recordsWritten;  ///< Number of records added so far
+    std::string recordBuffer; ///< Pending record bytes
+    std::string heapBuffer;   ///< Pending description bytes
+    uint64_t recordFileOffset;///< File offset for the next flushed record bytes
+    uint64_t heapFileOffset;  ///< File offset for the next flushed heap bytes
+
+    /**
+     * @brief Write a buffer at a file offset and clear it
+     * @param buffer Bytes to write
+     * @param offset File offset to write at, advanced by the bytes written
+     */
+    void flushBuffer(std::string& buffer, uint64_t& offset);
+
+public:
+    /**
+     * @brief Constructor for SnapshotWriter
+     * @param filename Name of the snapshot file to produce
+     * @param taskCount Exact number of tasks that will be added
+     * @param nextId Next available task ID to record in the header
+     * @param walSequence Last write-ahead log sequence the snapshot covers
+     */
+    SnapshotWriter(const std::string& filename, uint64_t taskCount, int nextId,
+                   uint64_t walSequence = 0);
+
+    /**
+     * @brief Destructor for SnapshotWriter
+     *
+     * Removes the temporary file if finish() was not called successfully.
+     */
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    /**
+     * @brief Append one task to the snapshot
+     * @param id Task identifier
+     * @param description Pointer to the description bytes
+     * @param length Length of the description
+     * @param urgency Urgency level (1-4)
+     * @param createdAtNs Creation time in nanoseconds since the Unix epoch
+     * @param completed Completion status
+     */
+    void add(int id, const char* description, size_t length, uint8_t urgency,
+             int64_t createdAtNs, bool completed);
+
+    /**
+     * @brief Complete the snapshot and publish it under its final name
+     * @return true if every write, the fsync and the rename succeeded
+     */
+    bool finish();
+};
+
+/**
+ * @brief Read-only, memory-mapped view of a binary snapshot
+ *
+ * Opening a snapshot maps the file and validates the header and every
+ * record's heap bounds; records and descriptions are then read in place
+ * without copying or parsing.
+ */
+class SnapshotFile {
+private:
+    const char* base;               ///< Start of the mapping
+    size_t mappedSize;              ///< Size of the mapping
+    const SnapshotHeader* header;   ///< Header inside the mapping
+    const SnapshotRecord* records;  ///< First record inside the mapping
+    const char* heap;               ///< Description heap inside the mapping
+    std::string errorMessage;       ///< Reason the last open() failed
+
+    /**
+     * @brief Unmap the current file, if any
+     */
+    void close();
+
+public:
+    /**
+     * @brief Constructor for SnapshotFile
+     *
+     * Creates an empty view; call open() to map a file.
+     */
+    SnapshotFile();
+
+    /**
+     * @brief Destructor for SnapshotFile
+     *
+     * Unmaps the file. Pointers obtained from the view become invalid.
+     */
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    /**
+     * @brief Map and validate a snapshot file
+     * @param filename Name of the snapshot file
+     * @return true if the file is a valid snapshot, false otherwise
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Get the reason the last open() failed
+     * @return Human-readable error description
+     */
+    const std::string& error() const { return errorMessage; }
+
+    /**
+     * @brief Get the number of tasks in the snapshot
+     * @return Task count
+     */
+    size_t size() const { return header ? static_cast<size_t>(header->taskCount) : 0; }
+
+    /**
+     * @brief Get the next available task ID stored in the snapshot
+     * @return Next task ID
+     */
+    int nextId() const { return header ? header->nextId : 1; }
+
+    /**
+     * @brief Get the last write-ahead log sequence included in the snapshot
+     * @return WAL sequence number, 0 if the snapshot is not tied to a WAL
+     */
+    uint64_t walSequence() const { return header ? header->walSequence : 0; }
+
+    /**
+     * @brief Get a record by position
+     * @param index Position of the record (0 to size() - 1)
+     * @return Reference to the record inside the mapping
+     */
+    const SnapshotRecord& record(size_t index) const { return records[index]; }
+
+    /**
+     * @brief Get the description bytes of a record
+     * @param rec Record obtained from this snapshot
+     * @return Pointer to the first description byte inside the mapping
+     */
+    const char* description(const SnapshotRecord& rec) const { return heap + rec.descOffset; }
+};
+
+#endif // TODO_SNAPSHOT_H
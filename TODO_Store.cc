@@ -0,0 +1,286 @@
+#include "TODO_Store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// DeferredFree Implementation
+DeferredFree::DeferredFree(std::pmr::memory_resource* memory) : resource(memory), pending(false) {}
+
+DeferredFree::~DeferredFree() {
+    reclaim();
+}
+
+void DeferredFree::retire(void* data, size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(Entry{data, size, alignment});
+    pending.store(true, std::memory_order_release);
+}
+
+void DeferredFree::reclaim() {
+    if (!pending.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Entry& entry : entries) {
+        resource->deallocate(entry.data, entry.size, entry.alignment);
+    }
+    entries.clear();   // Keeps the capacity for the next round
+    pending.store(false, std::memory_order_relaxed);
+}
+
+// DescriptionArena Implementation
+DescriptionArena::DescriptionArena(DeferredFree& blockStorage)
+    : storage(&blockStorage), blocks(blockStorage.memoryResource()), firstBlock(0), currentBlock(0),
+      currentUsed(kBlockSize), totalBytes(0) {}
+
+char* DescriptionArena::allocateBlock(size_t size) {
+    blocks.push_back(storage->allocateShared<char>(size, alignof(char)));
+    return blocks.back().get();
+}
+
+uint64_t DescriptionArena::add(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    totalBytes += text.size();
+
+    if (text.size() > kBlockSize / 4) {
+        std::memcpy(allocateBlock(text.size()), text.data(), text.size());
+        return static_cast<uint64_t>(firstBlock + blocks.size() - 1) << 32;
+    }
+
+    if (kBlockSize - currentUsed < text.size()) {
+        allocateBlock(kBlockSize);
+        currentBlock = blocks.size() - 1;
+        currentUsed = 0;
+    }
+    uint64_t ref = (static_cast<uint64_t>(firstBlock + currentBlock) << 32) | currentUsed;
+    std::memcpy(blocks[currentBlock].get() + currentUsed, text.data(), text.size());
+    currentUsed += text.size();
+    return ref;
+}
+
+size_t DescriptionArena::startBlock() {
+    currentUsed = kBlockSize;
+    return firstBlock + blocks.size();
+}
+
+void DescriptionArena::dropBlocksBefore(size_t blockNumber, size_t bytesDropped) {
+    size_t count = std::min(blockNumber - firstBlock, blocks.size());
+    blocks.erase(blocks.begin(), blocks.begin() + static_cast<std::ptrdiff_t>(count));
+    firstBlock += count;
+    if (currentBlock >= count) {
+        currentBlock -= count;
+    } else {
+        currentBlock = 0;
+        currentUsed = kBlockSize;   // The block being filled was dropped
+    }
+    totalBytes -= bytesDropped;
+}
+
+void DescriptionArena::clear() {
+    std::pmr::vector<Block>(storage->memoryResource()).swap(blocks);
+    firstBlock = 0;
+    currentBlock = 0;
+    currentUsed = kBlockSize;
+    totalBytes = 0;
+}
+
+// TaskStore Implementation
+TaskStore::TaskStore(std::pmr::memory_resource* memory)
+    : storage(memory), segments(memory), arena(storage), slots(0), removed(0),
+      compactionActive(false), compactRead(0), compactWrite(0), keptBlock(0), droppedBytes(0) {}
+
+TaskStore::Segment TaskStore::newSegment() {
+    storage.reclaim();
+    Segment segment = std::move(spare);
+    if (!segment) {
+        segment = storage.allocateShared<TaskSegment>(sizeof(TaskSegment), alignof(TaskSegment));
+    }
+    std::memset(segment->completedBits, 0, sizeof(segment->completedBits));
+    std::memset(segment->removedBits, 0, sizeof(segment->removedBits));
+    return segment;
+}
+
+TaskSegment& TaskStore::writableSegment(size_t index) {
+    Segment& segment = segments[index];
+    if (segment.use_count() > 1) {
+        // Snapshots keep the old copy; they never see the write
+        Segment copy = newSegment();
+        std::memcpy(copy.get(), segment.get(), sizeof(TaskSegment));
+        segment = std::move(copy);
+    } else {
+        // Pairs with the release of the last snapshot reference to this segment
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *segment;
+}
+
+void TaskStore::reserve(size_t extra) {
+    segments.reserve((slots + extra + kSegmentSlots - 1) / kSegmentSlots);
+}
+
+size_t TaskStore::append(int id, std::string_view description, uint8_t urgencyLevel,
+                         int64_t createdAt, bool completed) {
+    size_t slot = slots;
+    size_t index = slot % kSegmentSlots;
+    if (index == 0) {
+        segments.push_back(newSegment());
+    }
+    TaskSegment& segment = writableSegment(segments.size() - 1);
+    segment.ids[index] = id;
+    segment.urgencies[index] = urgencyLevel;
+    segment.createdTicks[index] = createdAt;
+    segment.descRefs[index] = arena.add(description);
+    segment.descLengths[index] = static_cast<uint32_t>(description.size());
+    if (completed) {
+        segment.completedBits[index >> 6] |= uint64_t(1) << (index & 63);
+    }
+    slots++;
+    return slot;
+}
+
+void TaskStore::setCompleted(size_t slot) {
+    size_t index = slot % kSegmentSlots;
+    writableSegment(slot / kSegmentSlots).completedBits[index >> 6] |= uint64_t(1) << (index & 63);
+}
+
+void TaskStore::remove(size_t slot) {
+    size_t index = slot % kSegmentSlots;
+    writableSegment(slot / kSegmentSlots).removedBits[index >> 6] |= uint64_t(1) << (index & 63);
+    removed++;
+}
+
+StoreSnapshot TaskStore::snapshot() const {
+    StoreSnapshot copy;
+    copy.segments.assign(segments.begin(), segments.end());
+    copy.blocks.assign(arena.blockList().begin(), arena.blockList().end());
+    copy.firstBlock = arena.firstBlockNumber();
+    copy.slots = slots;
+    copy.removed = removed;
+    copy.gapStart = gapBegin();
+    copy.gapStop = gapEnd();
+    return copy;
+}
+
+void TaskStore::unshareSegments() {
+    for (size_t index = 0; index < segments.size(); ++index) {
+        writableSegment(index);
+    }
+}
+
+size_t TaskStore::removeCompletedInShard(size_t shard) {
+    size_t count = 0;
+    size_t endSegment = (shardEnd(shard) + kSegmentSlots - 1) / kSegmentSlots;
+    for (size_t index = shardBegin(shard) / kSegmentSlots; index < endSegment; ++index) {
+        TaskSegment& segment = *segments[index];
+        for (size_t word = 0; word < kSegmentSlots / 64; ++word) {
+            uint64_t cleared = segment.completedBits[word] & ~segment.removedBits[word];
+            segment.removedBits[word] |= cleared;
+            count += static_cast<size_t>(__builtin_popcountll(cleared));
+        }
+    }
+    return count;
+}
+
+void TaskStore::beginCompaction() {
+    if (compactionActive) {
+        return;
+    }
+    compactionActive = true;
+    compactRead = 0;
+    compactWrite = 0;
+    // Everything stored so far is copied or dropped by the end of the pass
+    droppedBytes = arena.bytes();
+    keptBlock = arena.startBlock();
+}
+
+std::pair<size_t, size_t> TaskStore::compactStep(size_t slotBudget) {
+    size_t firstWritten = compactWrite;
+    size_t end = slotBudget < slots - compactRead ? compactRead + slotBudget : slots;
+    // Writes never pass reads, and every slot between the two is tombstoned
+    for (; compactRead < end; ++compactRead) {
+        size_t from = compactRead % kSegmentSlots;
+        const TaskSegment& in = segmentOf(compactRead);
+        if (in.isRemoved(from)) continue;
+        uint64_t ref = in.descRefs[from];
+        uint32_t length = in.descLengths[from];
+        bool oldText = length > 0 && DescriptionArena::blockOf(ref) < keptBlock;
+        if (compactWrite == compactRead && !oldText) {
+            compactWrite++;
+            continue;
+        }
+
+        int id = in.ids[from];
+        uint8_t urgency = in.urgencies[from];
+        int64_t created = in.createdTicks[from];
+        bool done = in.completed(from);
+        if (oldText) {
+            ref = arena.add(arena.get(ref, length));
+        }
+        size_t at = compactWrite % kSegmentSlots;
+        TaskSegment& out = writableSegment(compactWrite / kSegmentSlots);
+        out.ids[at] = id;
+        out.urgencies[at] = urgency;
+        out.createdTicks[at] = created;
+        out.descRefs[at] = ref;
+        out.descLengths[at] = length;
+        if (done) {
+            out.completedBits[at >> 6] |= uint64_t(1) << (at & 63);
+        } else {
+            out.completedBits[at >> 6] &= ~(uint64_t(1) << (at & 63));
+        }
+        out.removedBits[at >> 6] &= ~(uint64_t(1) << (at & 63));
+        if (compactWrite != compactRead) {
+            // The task now lives at compactWrite; its old slot joins the gap
+            writableSegment(compactRead / kSegmentSlots).removedBits[from >> 6] |= uint64_t(1) << (from & 63);
+        }
+        compactWrite++;
+    }
+    std::pair<size_t, size_t> written(firstWritten, compactWrite);
+    if (compactRead == slots) {
+        finishCompaction();
+    }
+    return written;
+}
+
+void TaskStore::finishCompaction() {
+    // Every slot from compactWrite on is tombstoned; cut them off
+    removed -= slots - compactWrite;
+    slots = compactWrite;
+    size_t segmentsLeft = (slots + kSegmentSlots - 1) / kSegmentSlots;
+    if (segmentsLeft < segments.size() && segments.back().use_count() == 1) {
+        spare = std::move(segments.back());
+    }
+    segments.resize(segmentsLeft);
+    size_t tail = slots % kSegmentSlots;
+    if (tail != 0) {
+        // Clear the bits past the end
+        TaskSegment& last = writableSegment(segmentsLeft - 1);
+        uint64_t keep = (uint64_t(1) << (tail & 63)) - 1;
+        size_t word = tail >> 6;
+        last.completedBits[word] &= keep;
+        last.removedBits[word] &= keep;
+        size_t rest = (kSegmentSlots / 64 - word - 1) * sizeof(uint64_t);
+        std::memset(last.completedBits + word + 1, 0, rest);
+        std::memset(last.removedBits + word + 1, 0, rest);
+    }
+    arena.dropBlocksBefore(keptBlock, droppedBytes);
+    compactionActive = false;
+    compactRead = 0;
+    compactWrite = 0;
+    storage.reclaim();
+}
+
+void TaskStore::clear() {
+    std::pmr::vector<Segment>(storage.memoryResource()).swap(segments);
+    spare.reset();
+    arena.clear();
+    slots = 0;
+    removed = 0;
+    compactionActive = false;
+    compactRead = 0;
+    compactWrite = 0;
+    storage.reclaim();
+}
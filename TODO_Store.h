@@ -0,0 +1,537 @@
+#ifndef TODO_STORE_H
+#define TODO_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Frees shared task storage once its last holder lets go
+ *
+ * Column segments and description blocks are shared with snapshots, and
+ * the last reference may be dropped on any thread. The memory resource
+ * behind them is not thread-safe and is only used while the store is
+ * being modified, so released storage is queued here and handed back to
+ * the resource by the next modification, or by the destructor.
+ */
+class DeferredFree {
+private:
+    struct Entry {
+        void* data;         ///< Start of the released storage
+        size_t size;        ///< Bytes allocated
+        size_t alignment;   ///< Alignment it was allocated with
+    };
+
+    std::pmr::memory_resource* resource;   ///< Where storage comes from and goes back to
+    std::mutex mutex;                      ///< Protects entries
+    std::vector<Entry> entries;            ///< Storage released but not yet freed
+    std::atomic<bool> pending;             ///< Whether entries may be non-empty
+
+    /**
+     * @brief Allocator for shared pointer control blocks
+     *
+     * Takes memory from the resource and hands it back through retire(),
+     * so a control block released by a reader is freed like the storage
+     * it owns.
+     */
+    template <typename U>
+    struct ControlAllocator {
+        typedef U value_type;
+        DeferredFree* owner;   ///< Where control blocks come from
+
+        explicit ControlAllocator(DeferredFree* source) : owner(source) {}
+        template <typename V>
+        ControlAllocator(const ControlAllocator<V>& other) : owner(other.owner) {}
+
+        U* allocate(size_t count) {
+            return static_cast<U*>(owner->resource->allocate(count * sizeof(U), alignof(U)));
+        }
+        void deallocate(U* data, size_t count) { owner->retire(data, count * sizeof(U), alignof(U)); }
+
+        template <typename V>
+        bool operator==(const ControlAllocator<V>& other) const { return owner == other.owner; }
+        template <typename V>
+        bool operator!=(const ControlAllocator<V>& other) const { return owner != other.owner; }
+    };
+
+public:
+    explicit DeferredFree(std::pmr::memory_resource* memory);
+    ~DeferredFree();
+
+    DeferredFree(const DeferredFree&) = delete;
+    DeferredFree& operator=(const DeferredFree&) = delete;
+
+    std::pmr::memory_resource* memoryResource() const { return resource; }
+
+    /**
+     * @brief Allocate storage owned by a shared pointer
+     * @param size Bytes to allocate
+     * @param alignment Alignment of the storage
+     * @return Pointer whose last owner queues the storage for freeing
+     *
+     * T must be trivially destructible; its destructor is not run.
+     */
+    template <typename T>
+    std::shared_ptr<T> allocateShared(size_t size, size_t alignment) {
+        T* data = static_cast<T*>(resource->allocate(size, alignment));
+        return std::shared_ptr<T>(data, [this, size, alignment](T* released) {
+            retire(released, size, alignment);
+        }, ControlAllocator<T>(this));
+    }
+
+    /**
+     * @brief Queue storage for freeing, from any thread
+     */
+    void retire(void* data, size_t size, size_t alignment);
+
+    /**
+     * @brief Free the queued storage; only while modifying the store
+     */
+    void reclaim();
+};
+
+/**
+ * @brief Append-only storage for task descriptions
+ *
+ * Descriptions are copied back to back into large blocks instead of each
+ * living in its own heap allocation. A description is addressed by the
+ * reference returned from add() plus its length. Blocks are never moved
+ * and bytes once written never change, so a view of a description stays
+ * valid as long as its block is held: by the arena until it drops the
+ * block, and by any snapshot that shares it. Blocks are numbered in the
+ * order they were allocated; space of removed descriptions is reclaimed
+ * by copying the live ones past a fresh block and dropping the blocks
+ * before it, which TaskStore's compaction does.
+ */
+class DescriptionArena {
+public:
+    typedef std::shared_ptr<char> Block;   ///< One block of description bytes
+
+private:
+    static const size_t kBlockSize = 1 << 20;   ///< Size of a regular block
+
+    DeferredFree* storage;             ///< Source of the blocks
+    std::pmr::vector<Block> blocks;    ///< All blocks kept, regular and oversized
+    size_t firstBlock;                 ///< Number of blocks[0]
+    size_t currentBlock;               ///< Index in blocks of the regular block being filled
+    size_t currentUsed;                ///< Bytes used in currentBlock
+    size_t totalBytes;                 ///< Bytes handed out by add()
+
+    char* allocateBlock(size_t size);
+
+public:
+    explicit DescriptionArena(DeferredFree& blockStorage);
+
+    DescriptionArena(const DescriptionArena&) = delete;
+    DescriptionArena& operator=(const DescriptionArena&) = delete;
+
+    /**
+     * @brief Copy a description into the arena
+     * @param text Description to store
+     * @return Reference to pass to get()
+     *
+     * Descriptions larger than a quarter block get a block of their own.
+     */
+    uint64_t add(std::string_view text);
+
+    /**
+     * @brief Look up a description in a list of blocks
+     * @param blockList The arena's blocks, or a snapshot's copy of them
+     * @param first Number of the first block in the list
+     * @param ref Reference returned by add()
+     * @param length Length of the description
+     * @return View of the stored bytes
+     */
+    template <typename BlockList>
+    static std::string_view get(const BlockList& blockList, size_t first, uint64_t ref, uint32_t length) {
+        if (length == 0) return std::string_view();
+        return std::string_view(blockList[(ref >> 32) - first].get() + (ref & 0xFFFFFFFFu), length);
+    }
+
+    std::string_view get(uint64_t ref, uint32_t length) const { return get(blocks, firstBlock, ref, length); }
+
+    /**
+     * @brief Get the number of the block a description is stored in
+     * @param ref Reference returned by add()
+     * @return Block number, comparable with startBlock()
+     */
+    static size_t blockOf(uint64_t ref) { return static_cast<size_t>(ref >> 32); }
+
+    /**
+     * @brief Get the blocks, for sharing them with a snapshot
+     * @return Every block kept, the first numbered firstBlockNumber()
+     */
+    const std::pmr::vector<Block>& blockList() const { return blocks; }
+
+    /**
+     * @brief Get the number of the first block kept
+     * @return Block number of blockList()[0]
+     */
+    size_t firstBlockNumber() const { return firstBlock; }
+
+    /**
+     * @brief Make the next add() start a new block
+     * @return Number of that block; every description added from now on is
+     *         stored in it or a later one
+     */
+    size_t startBlock();
+
+    /**
+     * @brief Let go of the oldest blocks
+     * @param blockNumber First block to keep, from startBlock()
+     * @param bytesDropped Description bytes stored in the blocks dropped
+     *
+     * No description still in use may be stored before blockNumber.
+     */
+    void dropBlocksBefore(size_t blockNumber, size_t bytesDropped);
+
+    /**
+     * @brief Get the number of description bytes stored
+     * @return Bytes stored, including those of removed tasks
+     */
+    size_t bytes() const { return totalBytes; }
+
+    /**
+     * @brief Release every block
+     */
+    void clear();
+};
+
+/**
+ * @brief Columns of kSlots consecutive task slots
+ *
+ * Plain data, allocated and copied as a whole. Bits of slots past the
+ * end of the store are always clear.
+ */
+struct TaskSegment {
+    static const size_t kSlots = 4096;   ///< Slots per segment, a multiple of 64
+
+    int64_t createdTicks[kSlots];            ///< Creation time as system_clock ticks per slot
+    uint64_t descRefs[kSlots];               ///< Arena reference of the description per slot
+    uint64_t completedBits[kSlots / 64];     ///< Completion flag per slot, 64 slots per word
+    uint64_t removedBits[kSlots / 64];       ///< Tombstone flag per slot, 64 slots per word
+    int ids[kSlots];                         ///< Task ID per slot
+    uint32_t descLengths[kSlots];            ///< Description length per slot
+    uint8_t urgencies[kSlots];               ///< Urgency level (1-4) per slot
+
+    bool completed(size_t index) const { return (completedBits[index >> 6] >> (index & 63)) & 1u; }
+    bool isRemoved(size_t index) const { return (removedBits[index >> 6] >> (index & 63)) & 1u; }
+};
+
+/**
+ * @brief Read-only copy of a TaskStore at one point in time
+ *
+ * Shares the store's segments and description blocks instead of copying
+ * them; see TaskStore::snapshot(). Has the store's read accessors.
+ */
+class StoreSnapshot {
+private:
+    std::vector<std::shared_ptr<const TaskSegment>> segments;   ///< Segments at capture time
+    std::vector<std::shared_ptr<const char>> blocks;            ///< Description blocks at capture time
+    size_t firstBlock;                                          ///< Number of blocks[0]
+    size_t slots;                                               ///< Slot count at capture time
+    size_t removed;                                             ///< Tombstoned slots at capture time
+    size_t gapStart;                                            ///< Compaction gap at capture time
+    size_t gapStop;                                             ///< End of that gap
+
+    friend class TaskStore;
+
+    const TaskSegment& segmentOf(size_t slot) const { return *segments[slot / TaskSegment::kSlots]; }
+
+public:
+    StoreSnapshot() : firstBlock(0), slots(0), removed(0), gapStart(0), gapStop(0) {}
+
+    size_t slotCount() const { return slots; }
+    size_t removedCount() const { return removed; }
+    size_t liveCount() const { return slots - removed; }
+    size_t gapBegin() const { return gapStart; }
+    size_t gapEnd() const { return gapStop; }
+
+    int id(size_t slot) const { return segmentOf(slot).ids[slot % TaskSegment::kSlots]; }
+    uint8_t urgencyLevel(size_t slot) const { return segmentOf(slot).urgencies[slot % TaskSegment::kSlots]; }
+    int64_t createdAt(size_t slot) const { return segmentOf(slot).createdTicks[slot % TaskSegment::kSlots]; }
+    bool completed(size_t slot) const { return segmentOf(slot).completed(slot % TaskSegment::kSlots); }
+    bool isRemoved(size_t slot) const { return segmentOf(slot).isRemoved(slot % TaskSegment::kSlots); }
+
+    std::string_view description(size_t slot) const {
+        const TaskSegment& segment = segmentOf(slot);
+        size_t index = slot % TaskSegment::kSlots;
+        return DescriptionArena::get(blocks, firstBlock, segment.descRefs[index], segment.descLengths[index]);
+    }
+};
+
+/**
+ * @brief Column-oriented storage for the tasks of a TodoApp
+ *
+ * Each task occupies one slot, and every field lives in its own array:
+ * IDs, urgency packed into a byte, creation time as clock ticks, a
+ * reference into a DescriptionArena, and completion and removal flags as
+ * bitsets. Scans that only need a field or two, such as counting by
+ * urgency, stream through a few bytes per task instead of whole task
+ * objects, and descriptions do not fragment the heap.
+ *
+ * Removal only sets the removed bit; compaction closes the gaps while
+ * preserving slot order, a bounded number of slots per compactStep()
+ * call, so a large store is compacted in short slices. The store does
+ * not know about IDs beyond keeping them; TodoApp maps IDs to slots.
+ *
+ * The columns are cut into TaskSegments held by shared pointers. A
+ * snapshot shares the current segments and description blocks, and the
+ * store copies a segment before writing to it while a snapshot still
+ * holds it, so snapshots never change. Storage is allocated from a
+ * memory resource, so a pool resource can serve add/remove churn without
+ * going back to the heap.
+ *
+ * For bulk work the slots are split into shards of kShardSlots
+ * consecutive slots. Shards cover whole segments, so threads can work on
+ * different shards at the same time without touching shared data.
+ */
+class TaskStore {
+public:
+    static const size_t kSegmentSlots = TaskSegment::kSlots;   ///< Slots per segment
+    static const size_t kShardSlots = 1 << 16;                ///< Slots per shard, a multiple of kSegmentSlots
+
+private:
+    typedef std::shared_ptr<TaskSegment> Segment;
+
+    DeferredFree storage;                  ///< Declared first so it is destroyed last
+    std::pmr::vector<Segment> segments;    ///< Columns, kSegmentSlots slots per segment
+    Segment spare;                         ///< Emptied segment kept for the next append
+    DescriptionArena arena;                ///< Storage for every description
+    size_t slots;                          ///< Number of slots in use
+    size_t removed;                        ///< Number of tombstoned slots
+
+    bool compactionActive;                 ///< Whether a compaction pass is under way
+    size_t compactRead;                    ///< Next slot the pass examines
+    size_t compactWrite;                   ///< Next slot the pass fills
+    size_t keptBlock;                      ///< First description block the pass keeps
+    size_t droppedBytes;                   ///< Description bytes stored before the pass began
+
+    /**
+     * @brief End the compaction pass once it has examined every slot
+     */
+    void finishCompaction();
+
+    const TaskSegment& segmentOf(size_t slot) const { return *segments[slot / kSegmentSlots]; }
+
+    /**
+     * @brief Get a segment for writing, copying it first if a snapshot holds it
+     * @param index Segment index
+     */
+    TaskSegment& writableSegment(size_t index);
+
+    /**
+     * @brief Allocate a segment whose bits are all clear
+     */
+    Segment newSegment();
+
+public:
+    /**
+     * @brief Constructor for TaskStore
+     * @param memory Resource that columns and descriptions are allocated from
+     */
+    explicit TaskStore(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    /**
+     * @brief Get the number of slots, including tombstoned ones
+     * @return Slot count
+     */
+    size_t slotCount() const { return slots; }
+
+    /**
+     * @brief Get the number of tombstoned slots
+     * @return Removed slot count
+     */
+    size_t removedCount() const { return removed; }
+
+    /**
+     * @brief Get the number of live tasks
+     * @return Slot count minus removed slots
+     */
+    size_t liveCount() const { return slots - removed; }
+
+    /**
+     * @brief Reserve room for more tasks
+     * @param extra Number of tasks about to be appended
+     */
+    void reserve(size_t extra);
+
+    /**
+     * @brief Append a task in a new slot
+     * @param id Task ID
+     * @param description Description, copied into the arena
+     * @param urgencyLevel Urgency level, 1-4
+     * @param createdAt Creation time as system_clock ticks
+     * @param completed Completion status
+     * @return Slot of the new task
+     */
+    size_t append(int id, std::string_view description, uint8_t urgencyLevel,
+                  int64_t createdAt, bool completed);
+
+    int id(size_t slot) const { return segmentOf(slot).ids[slot % kSegmentSlots]; }
+    uint8_t urgencyLevel(size_t slot) const { return segmentOf(slot).urgencies[slot % kSegmentSlots]; }
+    int64_t createdAt(size_t slot) const { return segmentOf(slot).createdTicks[slot % kSegmentSlots]; }
+    bool completed(size_t slot) const { return segmentOf(slot).completed(slot % kSegmentSlots); }
+    bool isRemoved(size_t slot) const { return segmentOf(slot).isRemoved(slot % kSegmentSlots); }
+
+    std::string_view description(size_t slot) const {
+        const TaskSegment& segment = segmentOf(slot);
+        size_t index = slot % kSegmentSlots;
+        return arena.get(segment.descRefs[index], segment.descLengths[index]);
+    }
+
+    /**
+     * @brief Mark the task in a slot as completed
+     * @param slot Slot of the task
+     */
+    void setCompleted(size_t slot);
+
+    /**
+     * @brief Tombstone a slot
+     * @param slot Slot of the task
+     */
+    void remove(size_t slot);
+
+    /**
+     * @brief Capture the current tasks
+     * @return Snapshot sharing the current segments and description blocks
+     *
+     * Costs a reference per segment and description block; no task is
+     * copied. The snapshot may be read from any thread without locking,
+     * but must be destroyed before the store.
+     */
+    StoreSnapshot snapshot() const;
+
+    /**
+     * @brief Get the number of shards the slots are split into
+     * @return Shard count, 0 if the store is empty
+     */
+    size_t shardCount() const { return (slots + kShardSlots - 1) / kShardSlots; }
+
+    /**
+     * @brief Get the first slot of a shard
+     * @param shard Shard index
+     * @return First slot
+     */
+    size_t shardBegin(size_t shard) const { return shard * kShardSlots; }
+
+    /**
+     * @brief Get the slot after the last slot of a shard
+     * @param shard Shard index
+     * @return End slot, at most slotCount()
+     */
+    size_t shardEnd(size_t shard) const {
+        return (shard + 1) * kShardSlots < slots ? (shard + 1) * kShardSlots : slots;
+    }
+
+    /**
+     * @brief Copy every segment that a snapshot still holds
+     *
+     * Call before removeCompletedInShard(), which must not allocate.
+     */
+    void unshareSegments();
+
+    /**
+     * @brief Tombstone every completed task of a shard
+     * @param shard Shard index
+     * @return Number of slots tombstoned
+     *
+     * May run concurrently for different shards, after unshareSegments().
+     * removedCount() is only updated by the matching countRemoved() call.
+     */
+    size_t removeCompletedInShard(size_t shard);
+
+    /**
+     * @brief Account for slots tombstoned by removeCompletedInShard()
+     * @param count Total returned by those calls
+     */
+    void countRemoved(size_t count) { removed += count; }
+
+    /**
+     * @brief Start closing the gaps left by tombstoned slots
+     *
+     * The pass moves each live task down to the next free slot, keeping
+     * their relative order, and copies its description past a fresh arena
+     * block, so that removed text is freed once no snapshot holds it. Work
+     * is done by compactStep(); the store may be read and modified between
+     * steps as usual. Does nothing if a pass is already under way.
+     */
+    void beginCompaction();
+
+    /**
+     * @brief Advance the compaction pass
+     * @param slotBudget Most slots to examine
+     * @return Range of slots written; each may hold a different task than
+     *         before. The pass ends, and compacting() turns false, once it
+     *         reaches the last slot.
+     */
+    std::pair<size_t, size_t> compactStep(size_t slotBudget);
+
+    /**
+     * @brief Check whether a compaction pass is under way
+     * @return true between beginCompaction() and the step that finishes it
+     */
+    bool compacting() const { return compactionActive; }
+
+    /**
+     * @brief Get the first slot of the gap a compaction pass has opened
+     * @return First slot between the compacted tasks and the ones not yet
+     *         examined, slotCount() without a pass
+     *
+     * Every slot of [gapBegin(), gapEnd()) is tombstoned and may hold a
+     * stale ID; outside the gap IDs ascend in slot order.
+     */
+    size_t gapBegin() const { return compactionActive ? compactWrite : slots; }
+
+    /**
+     * @brief Get the slot after the compaction gap
+     * @return Next slot the pass examines, slotCount() without a pass
+     */
+    size_t gapEnd() const { return compactionActive ? compactRead : slots; }
+
+    /**
+     * @brief Remove every task and release the storage
+     */
+    void clear();
+
+    // Raw columns, for kernels that scan a single field a segment at a time
+
+    size_t segmentCount() const { return segments.size(); }
+    const TaskSegment& segment(size_t index) const { return *segments[index]; }
+
+    /**
+     * @brief Get the number of slots in use in a segment
+     * @param index Segment index
+     * @return kSegmentSlots for every segment but the last
+     */
+    size_t segmentSlots(size_t index) const {
+        return index + 1 < segments.size() ? kSegmentSlots : slots - index * kSegmentSlots;
+    }
+};
+
+/**
+ * @brief Binary-search the slots of a store by ID, skipping the compaction gap
+ * @param store TaskStore or StoreSnapshot
+ * @param before Predicate on IDs that holds for every ID before the one sought
+ * @return First slot outside the gap whose ID fails the predicate, or slotCount()
+ */
+template <typename Store, typename Before>
+size_t partitionSlotsById(const Store& store, Before before) {
+    auto search = [&store, &before](size_t low, size_t high) {
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (before(store.id(mid))) low = mid + 1; else high = mid;
+        }
+        return low;
+    };
+    size_t slot = search(0, store.gapBegin());
+    return slot < store.gapBegin() ? slot : search(store.gapEnd(), store.slotCount());
+}
+
+#endif // TODO_STORE_H
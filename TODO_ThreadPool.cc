@@ -0,0 +1,101 @@
+#include "TODO_ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+
+// Pool and queue index of the worker running on this thread, if any
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) : queuedJobs(0), nextQueue(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::callerIndex() const {
+    return currentPool == this ? currentIndex : queues.size();
+}
+
+void ThreadPool::push(std::function<void()> job) {
+    size_t index = callerIndex();
+    if (index == queues.size()) {
+        index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+    // Count first, so queuedJobs never drops below zero when a thief is quick
+    queuedJobs.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(std::move(job));
+    }
+    {
+        // Pairs with the predicate check in workerLoop, so the wakeup is not lost
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    jobAvailable.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, std::function<void()>& job) {
+    if (queuedJobs.load() == 0) {
+        return false;
+    }
+    if (index < queues.size()) {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset <= queues.size(); ++offset) {
+        WorkerQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    std::function<void()> job;
+    while (true) {
+        if (pop(index, job)) {
+            job();
+            job = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobAvailable.wait(lock, [this] { return stopping || queuedJobs.load() > 0; });
+        if (stopping && queuedJobs.load() == 0) return; // Stopping and fully drained
+    }
+}
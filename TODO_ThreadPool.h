@@ -0,0 +1,172 @@
+#ifndef TODO_THREADPOOL_H
+#define TODO_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size work-stealing pool of worker threads for bulk operations
+ *
+ * Every worker has its own job queue. Jobs submitted from outside the pool
+ * are dealt to the queues round robin; jobs submitted by a job go to its
+ * own worker's queue. A worker takes its newest job first and, once its
+ * queue is empty, steals the oldest job of another worker, so a worker
+ * stuck with a long job does not hold up the rest. Each submit() returns
+ * a future for the job's result, so callers can fan work out and then
+ * collect results in whatever order they need.
+ */
+class ThreadPool {
+private:
+    /**
+     * @brief Job queue of one worker
+     */
+    struct WorkerQueue {
+        std::mutex mutex;                           ///< Protects jobs
+        std::deque<std::function<void()>> jobs;     ///< Jobs waiting for a worker
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;   ///< One queue per worker
+    std::vector<std::thread> workers;                   ///< Worker threads
+    std::atomic<size_t> queuedJobs;                     ///< Jobs in all queues
+    std::atomic<size_t> nextQueue;                      ///< Round-robin position for outside submits
+    std::mutex sleepMutex;                              ///< Protects stopping, pairs with jobAvailable
+    std::condition_variable jobAvailable;               ///< Signals idle workers that a job was queued
+    bool stopping;                                      ///< Set when the pool is shutting down
+
+    /**
+     * @brief Main loop of every worker thread
+     * @param index Index of the worker's queue
+     */
+    void workerLoop(size_t index);
+
+    /**
+     * @brief Queue a job on the caller's own queue or the next one in turn
+     * @param job Job to queue
+     */
+    void push(std::function<void()> job);
+
+    /**
+     * @brief Take a job: the newest of the own queue, else the oldest of another
+     * @param index Queue to start from
+     * @param job Receives the job
+     * @return true if a job was taken
+     */
+    bool pop(size_t index, std::function<void()>& job);
+
+    /**
+     * @brief Get the queue index of the calling thread
+     * @return Index of the worker, or queues.size() if the caller is not one
+     */
+    size_t callerIndex() const;
+
+public:
+    /**
+     * @brief Constructor for ThreadPool
+     * @param threadCount Number of worker threads (0 = one per hardware thread)
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * @brief Destructor for ThreadPool
+     *
+     * Finishes every queued job, then joins the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Get the number of worker threads
+     * @return Worker thread count
+     */
+    size_t size() const { return workers.size(); }
+
+    /**
+     * @brief Queue a job for execution on a worker thread
+     * @param func Callable taking no arguments
+     * @return Future that receives the callable's result or exception
+     */
+    template <typename Func>
+    auto submit(Func func) -> std::future<decltype(func())> {
+        typedef decltype(func()) Result;
+        std::shared_ptr<std::packaged_task<Result()>> job =
+            std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = job->get_future();
+        push([job] { (*job)(); });
+        return result;
+    }
+
+    /**
+     * @brief Run func(0) ... func(count - 1) on the pool and the calling thread
+     * @param count Number of parts, typically shards
+     * @param func Callable taking the part index; must not throw
+     *
+     * Parts are claimed one at a time from a shared counter, so threads that
+     * finish cheap parts early take over the remaining ones. The caller
+     * works on parts too and returns after every part has finished. Safe to
+     * call from inside a job.
+     */
+    template <typename Func>
+    void parallelFor(size_t count, Func func);
+};
+
+template <typename Func>
+void ThreadPool::parallelFor(size_t count, Func func) {
+    if (count <= 1) {
+        if (count == 1) func(0);
+        return;
+    }
+
+    // Helpers that start after the last part was claimed must not touch func,
+    // which lives on this stack frame, so they only see the shared progress
+    struct Progress {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+    Func* body = &func;
+    auto runParts = [progress, body, count] {
+        size_t finishedHere = 0;
+        for (size_t part; (part = progress->next.fetch_add(1)) < count; ++finishedHere) {
+            (*body)(part);
+        }
+        if (finishedHere > 0 && progress->finished.fetch_add(finishedHere) + finishedHere == count) {
+            std::lock_guard<std::mutex> lock(progress->mutex);
+            progress->done.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(count - 1, size());
+    for (size_t i = 0; i < helpers; ++i) {
+        push(runParts);
+    }
+    runParts();
+
+    // Run other queued jobs while waiting, so nested calls cannot starve the pool
+    std::function<void()> job;
+    size_t self = callerIndex();
+    while (progress->finished.load() < count) {
+        if (pop(self, job)) {
+            job();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(progress->mutex);
+        progress->done.wait_for(lock, std::chrono::milliseconds(1),
+                                [&progress, count] { return progress->finished.load() == count; });
+    }
+}
+
+#endif // TODO_THREADPOOL_H
@@ -0,0 +1,154 @@
+#include "TODO_Time.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// Decode exactly `count` ASCII digits, returning -1 if any is not a digit
+int parseDigits(const char* text, int count) {
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        unsigned digit = static_cast<unsigned>(text[i] - '0');
+        if (digit > 9) return -1;
+        value = value * 10 + static_cast<int>(digit);
+    }
+    return value;
+}
+
+// Start of the most recently parsed local hour, cached per thread
+struct HourCache {
+    char key[13];           // "YYYY-MM-DD HH"
+    std::time_t hourStart;  // Seconds since the epoch at HH:00:00 local time
+    bool valid;
+};
+
+thread_local HourCache hourCache = {{0}, 0, false};
+
+// Text of the most recently formatted local minute, cached per thread
+struct MinuteCache {
+    char prefix[17];          // "YYYY-MM-DD HH:MM:"
+    std::time_t minuteStart;  // Seconds since the epoch at the start of that minute
+    bool valid;
+};
+
+thread_local MinuteCache minuteCache = {{0}, 0, false};
+
+// Epoch seconds accepted by parseTimestamp(), within the range of system_clock ticks
+const int64_t kMaxEpochSeconds = 9000000000ll;   // About the year 2255
+
+void writeDigits(char* out, int value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+} // namespace
+
+bool parseLocalTimestamp(const char* text, size_t length,
+                         std::chrono::system_clock::time_point& out) {
+    if (length < kTimestampLength || text[4] != '-' || text[7] != '-' ||
+        text[10] != ' ' || text[13] != ':' || text[16] != ':') {
+        return false;
+    }
+
+    int minute = parseDigits(text + 14, 2);
+    int second = parseDigits(text + 17, 2);
+    if (minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return false;
+    }
+
+    if (!hourCache.valid || std::memcmp(hourCache.key, text, sizeof(hourCache.key)) != 0) {
+        int year = parseDigits(text, 4);
+        int month = parseDigits(text + 5, 2);
+        int day = parseDigits(text + 8, 2);
+        int hour = parseDigits(text + 11, 2);
+        if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23) {
+            return false;
+        }
+
+        std::tm local;
+        std::memset(&local, 0, sizeof(local));
+        local.tm_year = year - 1900;
+        local.tm_mon = month - 1;
+        local.tm_mday = day;
+        local.tm_hour = hour;
+        local.tm_isdst = -1;
+        std::time_t hourStart = std::mktime(&local);
+        if (hourStart == static_cast<std::time_t>(-1)) {
+            return false;
+        }
+
+        std::memcpy(hourCache.key, text, sizeof(hourCache.key));
+        hourCache.hourStart = hourStart;
+        hourCache.valid = true;
+    }
+
+    out = std::chrono::system_clock::from_time_t(hourCache.hourStart + minute * 60 + second);
+    return true;
+}
+
+void formatLocalTimestamp(std::chrono::system_clock::time_point time, char* out) {
+    // Round down, as to_time_t() would round times before 1970 towards zero
+    std::time_t seconds = static_cast<std::time_t>(
+        std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count());
+    std::time_t minuteStart = seconds - ((seconds % 60) + 60) % 60;
+
+    if (!minuteCache.valid || minuteCache.minuteStart != minuteStart) {
+        std::tm local;
+        if (!localtime_r(&minuteStart, &local)) {
+            std::memset(&local, 0, sizeof(local));
+        }
+        char* prefix = minuteCache.prefix;
+        writeDigits(prefix, (local.tm_year + 1900) % 10000, 4);
+        prefix[4] = '-';
+        writeDigits(prefix + 5, local.tm_mon + 1, 2);
+        prefix[7] = '-';
+        writeDigits(prefix + 8, local.tm_mday, 2);
+        prefix[10] = ' ';
+        writeDigits(prefix + 11, local.tm_hour, 2);
+        prefix[13] = ':';
+        writeDigits(prefix + 14, local.tm_min, 2);
+        prefix[16] = ':';
+        minuteCache.minuteStart = minuteStart;
+        minuteCache.valid = true;
+    }
+
+    std::memcpy(out, minuteCache.prefix, sizeof(minuteCache.prefix));
+    writeDigits(out + 17, static_cast<int>(seconds - minuteStart), 2);
+}
+
+size_t formatTimestamp(std::chrono::system_clock::time_point time, TimestampFormat format, char* out) {
+    if (format == TimestampFormat::LOCAL) {
+        formatLocalTimestamp(time, out);
+        return kTimestampLength;
+    }
+    int64_t seconds = std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count();
+    return static_cast<size_t>(std::to_chars(out, out + kMaxTimestampLength, seconds).ptr - out);
+}
+
+bool parseTimestamp(const char* text, size_t length,
+                    std::chrono::system_clock::time_point& out) {
+    if (length >= kTimestampLength && text[4] == '-') {
+        return parseLocalTimestamp(text, length, out);
+    }
+
+    const char* end = text + length;
+    int64_t seconds = 0;
+    std::from_chars_result parsed = std::from_chars(text, end, seconds);
+    if (parsed.ec != std::errc() || seconds > kMaxEpochSeconds || seconds < -kMaxEpochSeconds) {
+        return false;
+    }
+    if (parsed.ptr < end) {
+        unsigned char next = static_cast<unsigned char>(*parsed.ptr);
+        if (std::isalnum(next) || next == '-' || next == ':' || next == '.') {
+            return false;
+        }
+    }
+    out = std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef TODO_TIME_H
+#define TODO_TIME_H
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Length of a formatted timestamp ("YYYY-MM-DD HH:MM:SS")
+ */
+const size_t kTimestampLength = 19;
+
+/**
+ * @brief Most characters formatTimestamp() writes in any format
+ */
+const size_t kMaxTimestampLength = 20;
+
+/**
+ * @brief How exported files write times
+ */
+enum class TimestampFormat {
+    LOCAL,   ///< Local time, "YYYY-MM-DD HH:MM:SS"
+    EPOCH    ///< Whole seconds since the Unix epoch, e.g. "1714555800"
+};
+
+/**
+ * @brief Parse a local-time timestamp in "YYYY-MM-DD HH:MM:SS" format
+ * @param text Pointer to the first character of the timestamp
+ * @param length Number of characters available at text
+ * @param out Receives the parsed time point on success
+ * @return true if text starts with a valid timestamp, false otherwise
+ *
+ * Reads back what Task::getCreatedTimeString() produces. The digits are
+ * decoded by hand instead of going through std::get_time, and the local
+ * time zone conversion is cached per thread for the most recent hour, so
+ * std::mktime() runs only once for every distinct hour in the input.
+ * Safe to call concurrently from several threads.
+ *
+ * @par Example:
+ * @code
+ * std::chrono::system_clock::time_point created;
+ * parseLocalTimestamp("2024-01-15 09:15:32", 19, created);
+ * @endcode
+ */
+bool parseLocalTimestamp(const char* text, size_t length,
+                         std::chrono::system_clock::time_point& out);
+
+/**
+ * @brief Format a time point as local time in "YYYY-MM-DD HH:MM:SS" format
+ * @param time Time point to format
+ * @param out Receives exactly kTimestampLength characters, not terminated
+ *
+ * Produces the same text as std::put_time() with "%Y-%m-%d %H:%M:%S".
+ * The date, hour and minute for the most recent minute are cached per
+ * thread, so std::localtime_r() runs only once for every distinct minute
+ * and tasks created close together are formatted with a few stores.
+ * Safe to call concurrently from several threads.
+ */
+void formatLocalTimestamp(std::chrono::system_clock::time_point time, char* out);
+
+/**
+ * @brief Format a time point in either timestamp format
+ * @param time Time point to format
+ * @param format Format to write
+ * @param out Receives up to kMaxTimestampLength characters, not terminated
+ * @return Number of characters written
+ *
+ * LOCAL goes through formatLocalTimestamp(); EPOCH rounds down to whole
+ * seconds and writes them with std::to_chars, without any time zone
+ * lookup. Safe to call concurrently from several threads.
+ */
+size_t formatTimestamp(std::chrono::system_clock::time_point time, TimestampFormat format, char* out);
+
+/**
+ * @brief Parse a timestamp written in either format
+ * @param text Pointer to the first character of the timestamp
+ * @param length Number of characters available at text
+ * @param out Receives the parsed time point on success
+ * @return true if text starts with a valid timestamp, false otherwise
+ *
+ * Text shaped like "YYYY-MM-DD" is read by parseLocalTimestamp(); anything
+ * else must be an integer number of seconds since the Unix epoch, not
+ * followed by further digits, letters or timestamp punctuation. Lets the
+ * importers read files exported with either TimestampFormat.
+ */
+bool parseTimestamp(const char* text, size_t length,
+                    std::chrono::system_clock::time_point& out);
+
+#endif // TODO_TIME_H
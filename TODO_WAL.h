@@ -0,0 +1,260 @@
+#ifndef TODO_WAL_H
+#define TODO_WAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Types of records stored in the write-ahead log
+ *
+ * One record is written per task mutation, or per batch of mutations
+ * of the same kind. The numeric values are part of the on-disk format
+ * and must never change.
+ */
+enum class WalRecordType : uint8_t {
+    ADD_TASK = 1,         ///< A task was added
+    REMOVE_TASK = 2,      ///< A task was removed
+    COMPLETE_TASK = 3,    ///< A task was marked as completed
+    CLEAR_COMPLETED = 4,  ///< All completed tasks were removed
+    ADD_TASKS = 5,        ///< Several tasks were added
+    REMOVE_TASKS = 6,     ///< Several tasks were removed
+    COMPLETE_TASKS = 7    ///< Several tasks were marked as completed
+};
+
+/**
+ * @brief One task of an ADD_TASKS record
+ */
+struct WalAddEntry {
+    int id;                        ///< Task identifier
+    uint8_t urgency;               ///< Urgency level (1-4)
+    int64_t createdAtNs;           ///< Creation time in nanoseconds since the Unix epoch
+    std::string_view description;  ///< Task description
+};
+
+/**
+ * @brief Decoded write-ahead log record
+ *
+ * Only ADD_TASK records use the urgency, creation time and description
+ * fields; CLEAR_COMPLETED records use none of the payload fields. Batch
+ * records are never handed out as such: replay() splits them into one
+ * single-task record per entry, all with the batch's sequence number and
+ * told apart by batchIndex.
+ */
+struct WalRecord {
+    WalRecordType type;       ///< Kind of mutation
+    uint64_t sequence;        ///< Sequence number (strictly increasing, starting at 1)
+    uint32_t batchIndex;      ///< Position within a batch record, 0 for a single-task record
+    int id;                   ///< Task identifier
+    uint8_t urgency;          ///< Urgency level (1-4)
+    int64_t createdAtNs;      ///< Creation time in nanoseconds since the Unix epoch
+    std::string description;  ///< Task description
+};
+
+/**
+ * @brief Append-only binary log of task mutations with group commit
+ *
+ * Every record is framed as a 4-byte payload length, a 4-byte CRC-32 of
+ * everything after the checksum, an 8-byte sequence number, a 1-byte
+ * record type and the payload. Appending only encodes the record into an
+ * in-memory buffer; commit() makes it durable. When several threads
+ * commit at once, the first one writes and fsyncs every pending record
+ * while the others wait, so one fsync is shared by the whole group.
+ */
+class WriteAheadLog {
+private:
+    int fd;                               ///< Descriptor of the log file, -1 when closed
+    std::string fileName;                 ///< Name of the log file
+    std::mutex mutex;                     ///< Protects every member below
+    std::condition_variable durableCondition; ///< Signals that durableSequence advanced
+    std::string pending;                  ///< Encoded records not yet written
+    std::string spare;                    ///< Recycled buffer swapped with pending
+    uint64_t appendedSequence;            ///< Sequence of the last appended record
+    uint64_t durableSequence;             ///< Sequence of the last fsynced record
+    uint64_t fileBytes;                   ///< Bytes written to the file so far
+    bool flushing;                        ///< Set while a group leader writes
+    bool failed;                          ///< Set once a write or fsync has failed
+
+    /**
+     * @brief Frame and buffer one record
+     * @param type Kind of mutation
+     * @param payload Encoded payload bytes
+     * @param length Length of the payload
+     * @param tail Bytes appended to the payload, such as a description
+     * @return Sequence number assigned to the record
+     */
+    uint64_t append(WalRecordType type, const char* payload, size_t length,
+                    std::string_view tail = std::string_view());
+
+public:
+    /**
+     * @brief Constructor for WriteAheadLog
+     *
+     * Creates a closed log; call open() before appending.
+     */
+    WriteAheadLog();
+
+    /**
+     * @brief Destructor for WriteAheadLog
+     *
+     * Commits any appended records and closes the file.
+     */
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Create or open a log file for appending
+     * @param filename Name of the log file
+     * @param lastSequence Sequence of the last record already applied;
+     *        new records are numbered from lastSequence + 1
+     * @return true if the file was opened, false otherwise
+     */
+    bool open(const std::string& filename, uint64_t lastSequence);
+
+    /**
+     * @brief Commit pending records and close the file
+     */
+    void close();
+
+    /**
+     * @brief Append an ADD_TASK record
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendAdd(int id, std::string_view description, uint8_t urgency,
+                       int64_t createdAtNs);
+
+    /**
+     * @brief Append a REMOVE_TASK record
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendRemove(int id);
+
+    /**
+     * @brief Append a COMPLETE_TASK record
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendComplete(int id);
+
+    /**
+     * @brief Append a CLEAR_COMPLETED record
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendClearCompleted();
+
+    /**
+     * @brief Append one ADD_TASKS record covering several new tasks
+     * @param entries Tasks in the order they were added
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendAddBatch(const std::vector<WalAddEntry>& entries);
+
+    /**
+     * @brief Append one REMOVE_TASKS record
+     * @param ids IDs of the removed tasks
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendRemoveBatch(const std::vector<int>& ids);
+
+    /**
+     * @brief Append one COMPLETE_TASKS record
+     * @param ids IDs of the completed tasks
+     * @return Sequence number assigned to the record
+     */
+    uint64_t appendCompleteBatch(const std::vector<int>& ids);
+
+    /**
+     * @brief Wait until a record is durable on disk
+     * @param sequence Sequence number returned by one of the append calls
+     * @return true once the record is fsynced, false if the log has failed
+     *
+     * Either becomes the group leader and writes every pending record
+     * with a single write() and fdatasync(), or waits for the current
+     * leader to cover the requested sequence.
+     */
+    bool commit(uint64_t sequence);
+
+    /**
+     * @brief Get the sequence number of the last appended record
+     * @return Sequence number, 0 if nothing was ever appended
+     */
+    uint64_t lastSequence();
+
+    /**
+     * @brief Get the number of bytes written to the current file
+     * @return File size in bytes
+     */
+    uint64_t size();
+
+    /**
+     * @brief Replay the records of a log file
+     * @param filename Name of the log file
+     * @param apply Callback invoked for every valid record, in order
+     * @param truncateTornTail Whether to cut the file at the first invalid record
+     * @return Sequence number of the last valid record, 0 if there is none
+     *
+     * Stops at the first record that is truncated or fails its checksum,
+     * which is where a crash interrupted the last write.
+     */
+    static uint64_t replay(const std::string& filename,
+                           const std::function<void(const WalRecord&)>& apply,
+                           bool truncateTornTail);
+};
+
+/**
+ * @brief Files that make up a durable data directory
+ *
+ * A data directory holds checkpoint snapshots named
+ * snapshot-<sequence>.snap, where sequence is the last WAL record the
+ * snapshot covers, and WAL segments named wal-<sequence>.log, where
+ * sequence is the first record the segment may contain.
+ */
+struct DataDirectoryFiles {
+    std::vector<uint64_t> snapshots;   ///< Snapshot sequences, ascending
+    std::vector<uint64_t> segments;    ///< WAL segment start sequences, ascending
+};
+
+/**
+ * @brief List the snapshots and WAL segments in a data directory
+ * @param directory Path of the data directory
+ * @return Sorted sequences of every recognized file
+ */
+DataDirectoryFiles listDataDirectory(const std::string& directory);
+
+/**
+ * @brief Build the path of a checkpoint snapshot
+ * @param directory Path of the data directory
+ * @param sequence Last WAL sequence covered by the snapshot
+ * @return Full path of the snapshot file
+ */
+std::string snapshotPath(const std::string& directory, uint64_t sequence);
+
+/**
+ * @brief Build the path of a WAL segment
+ * @param directory Path of the data directory
+ * @param sequence First WAL sequence stored in the segment
+ * @return Full path of the segment file
+ */
+std::string walSegmentPath(const std::string& directory, uint64_t sequence);
+
+/**
+ * @brief Compute the CRC-32 (IEEE 802.3) of a byte range
+ * @param data First byte
+ * @param length Number of bytes
+ * @return Checksum, as stored in WAL frames
+ */
+uint32_t crc32(const char* data, size_t length);
+
+/**
+ * @brief Flush directory entries (creations, renames, deletions) to disk
+ * @param directory Path of the directory
+ * @return true if the directory was synced
+ */
+bool syncDirectory(const std::string& directory);
+
+#endif // TODO_WAL_H
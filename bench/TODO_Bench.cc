@@ -0,0 +1,135 @@
+/**
+ * @brief Benchmark of the task counting kernels
+ *
+ * Compares counting tasks by urgency and completion state the way the
+ * app used to, with std::count_if over a vector of Task objects, against
+ * the column kernels in TODO_Simd.h, both scalar and vectorized.
+ *
+ * Build from the repository root:
+ *   g++ -std=c++17 -O2 -pthread -I. -o todo_bench bench/TODO_Bench.cc TODO_Simd.cc TODO_Store.cc
+ * Run:
+ *   ./todo_bench [task count]
+ */
+
+#include "TODO_Simd.h"
+#include "TODO_Store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Task layout before the columnar store
+struct LegacyTask {
+    int id;
+    std::string description;
+    int urgency;
+    std::chrono::system_clock::time_point createdAt;
+    bool completed;
+};
+
+const int kRepetitions = 20;
+
+template <typename Func>
+double bestMilliseconds(Func func) {
+    double best = 0;
+    for (int run = 0; run < kRepetitions; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+TaskStateCounts countLegacy(const std::vector<LegacyTask>& tasks) {
+    TaskStateCounts result = {};
+    for (int level = 1; level <= 4; ++level) {
+        result.counts[level - 1][0] = static_cast<size_t>(std::count_if(tasks.begin(), tasks.end(),
+            [level](const LegacyTask& task) { return task.urgency == level && !task.completed; }));
+        result.counts[level - 1][1] = static_cast<size_t>(std::count_if(tasks.begin(), tasks.end(),
+            [level](const LegacyTask& task) { return task.urgency == level && task.completed; }));
+    }
+    return result;
+}
+
+// Run the kernel over every segment of the store and add up the counts
+TaskStateCounts countStore(const TaskStore& store) {
+    TaskStateCounts total = {};
+    for (size_t index = 0; index < store.segmentCount(); ++index) {
+        const TaskSegment& segment = store.segment(index);
+        TaskStateCounts counts = countTaskStates(segment.urgencies, segment.completedBits,
+                                                 segment.removedBits, store.segmentSlots(index));
+        for (int level = 0; level < 4; ++level) {
+            total.counts[level][0] += counts.counts[level][0];
+            total.counts[level][1] += counts.counts[level][1];
+        }
+    }
+    return total;
+}
+
+bool sameCounts(const TaskStateCounts& a, const TaskStateCounts& b) {
+    for (int level = 0; level < 4; ++level) {
+        if (a.counts[level][0] != b.counts[level][0] || a.counts[level][1] != b.counts[level][1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t taskCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::mt19937 random(42);
+    std::vector<LegacyTask> tasks;
+    tasks.reserve(taskCount);
+    TaskStore store;
+    store.reserve(taskCount);
+    auto now = std::chrono::system_clock::now();
+    for (size_t i = 0; i < taskCount; ++i) {
+        int urgency = static_cast<int>(random() % 4) + 1;
+        bool completed = random() % 3 == 0;
+        std::string description = "Task number " + std::to_string(i);
+        store.append(static_cast<int>(i + 1), description, static_cast<uint8_t>(urgency),
+                     now.time_since_epoch().count(), completed);
+        tasks.push_back({static_cast<int>(i + 1), std::move(description), urgency, now, completed});
+    }
+
+    TaskStateCounts legacy = {}, scalar = {}, vectorized = {};
+    double legacyMs = bestMilliseconds([&] { legacy = countLegacy(tasks); });
+
+    forceScalarKernels(true);
+    double scalarMs = bestMilliseconds([&] {
+        scalar = countStore(store);
+    });
+
+    forceScalarKernels(false);
+    double vectorMs = bestMilliseconds([&] {
+        vectorized = countStore(store);
+    });
+
+    if (!sameCounts(legacy, scalar) || !sameCounts(legacy, vectorized)) {
+        std::cout << "Error: Kernel counts do not match std::count_if." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Counting " << taskCount << " tasks by urgency and status, best of "
+              << kRepetitions << " runs" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(28) << "std::count_if over Task" << legacyMs << " ms" << std::endl;
+    std::cout << std::left << std::setw(28) << "scalar column kernel" << scalarMs << " ms ("
+              << legacyMs / scalarMs << "x)" << std::endl;
+    std::cout << std::left << std::setw(28) << (std::string(activeSimdKernel()) + " column kernel")
+              << vectorMs << " ms (" << legacyMs / vectorMs << "x)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @brief Benchmark of the TodoApp core operations
+ *
+ * Fills a TodoApp with addTask() and times the public operations on it:
+ * lookups, single-task mutations, urgency queries, statistics, the three
+ * text exporters and clearCompleted(), once per task count. Output goes to
+ * nullSink(), so no console I/O is measured; the action log is written to
+ * a file in the output directory, as the app would, and deleted at the end.
+ *
+ * Build from the repository root:
+ *   g++ -std=c++17 -O2 -pthread -I. -o todo_core_bench bench/TODO_CoreBench.cc \
+ *       TODO_App.cc TODO_ColdStore.cc TODO_Console.cc TODO_Import.cc TODO_Logger.cc \
+ *       TODO_Metrics.cc TODO_Output.cc TODO_Query.cc TODO_Search.cc TODO_Simd.cc \
+ *       TODO_Snapshot.cc TODO_Store.cc TODO_ThreadPool.cc TODO_Time.cc TODO_WAL.cc
+ * Run:
+ *   ./todo_core_bench [--dir DIRECTORY] [task count...]
+ *
+ * The task counts default to 1000, 100000 and 10000000. Run the same
+ * binary before and after a change to compare the two.
+ */
+
+#include "TODO_App.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t kMaxMutations = 100000;   // Single-task calls timed per mutation benchmark
+const size_t kLookups = 1000000;       // findTaskById() calls timed per task count
+
+typedef std::chrono::steady_clock Clock;
+
+double millisecondsSince(Clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+// Print one result row: name, task count, calls, total time and time per call
+void report(const char* name, size_t taskCount, size_t calls, double milliseconds) {
+    std::cout << std::left << std::setw(22) << name
+              << std::right << std::setw(10) << taskCount
+              << std::setw(10) << calls
+              << std::setw(14) << std::fixed << std::setprecision(3) << milliseconds
+              << std::setw(16) << std::setprecision(1) << milliseconds * 1e6 / static_cast<double>(calls)
+              << std::endl;
+}
+
+// Distinct random IDs in [1, taskCount], so no call hits a missing task
+std::vector<int> sampleIds(std::mt19937& random, size_t taskCount, size_t count) {
+    std::vector<int> ids(taskCount);
+    for (size_t i = 0; i < taskCount; ++i) {
+        ids[i] = static_cast<int>(i + 1);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::swap(ids[i], ids[i + random() % (taskCount - i)]);
+    }
+    ids.resize(count);
+    return ids;
+}
+
+void runBenchmarks(size_t taskCount, const std::string& directory) {
+    std::mt19937 random(42);
+    std::string logFile = directory + "/todo_bench_log.txt";
+    std::string exportBase = directory + "/todo_bench_export";
+    {
+        TodoApp app(logFile);
+        app.setOutputSink(nullSink());
+
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < taskCount; ++i) {
+            app.addTask("Benchmark task number " + std::to_string(i),
+                        intToUrgency(static_cast<int>(random() % 4) + 1));
+        }
+        report("addTask", taskCount, taskCount, millisecondsSince(start));
+
+        std::vector<int> lookups(kLookups);
+        for (int& id : lookups) {
+            id = static_cast<int>(random() % taskCount) + 1;
+        }
+        size_t found = 0;
+        start = Clock::now();
+        for (int id : lookups) {
+            found += app.findTaskById(id).has_value();
+        }
+        report("findTaskById", taskCount, kLookups, millisecondsSince(start));
+        if (found != kLookups) {
+            std::cout << "Error: findTaskById() missed " << kLookups - found << " tasks." << std::endl;
+        }
+
+        // Complete a third of the tasks, so clearCompleted() has work to do
+        size_t completions = std::max<size_t>(1, std::min(taskCount / 3, kMaxMutations));
+        std::vector<int> sample = sampleIds(random, taskCount, completions + std::min(taskCount / 3, kMaxMutations));
+        start = Clock::now();
+        for (size_t i = 0; i < completions; ++i) {
+            app.markCompleted(sample[i]);
+        }
+        report("markCompleted", taskCount, completions, millisecondsSince(start));
+
+        size_t matched = 0;
+        start = Clock::now();
+        for (int level = 1; level <= 4; ++level) {
+            matched += app.getTasksByUrgency(intToUrgency(level)).size();
+        }
+        report("getTasksByUrgency x4", taskCount, 4, millisecondsSince(start));
+        if (matched != taskCount) {
+            std::cout << "Error: getTasksByUrgency() returned " << matched << " tasks." << std::endl;
+        }
+
+        start = Clock::now();
+        app.displayStatistics();
+        report("displayStatistics", taskCount, 1, millisecondsSince(start));
+
+        start = Clock::now();
+        app.exportToFile(exportBase + ".txt");
+        report("exportToFile", taskCount, 1, millisecondsSince(start));
+        start = Clock::now();
+        app.exportToCSV(exportBase + ".csv");
+        report("exportToCSV", taskCount, 1, millisecondsSince(start));
+        start = Clock::now();
+        app.exportToJSON(exportBase + ".json");
+        report("exportToJSON", taskCount, 1, millisecondsSince(start));
+        std::remove((exportBase + ".txt").c_str());
+        std::remove((exportBase + ".csv").c_str());
+        std::remove((exportBase + ".json").c_str());
+
+        // Remove tasks other than the completed ones, then clear those
+        size_t removals = sample.size() - completions;
+        start = Clock::now();
+        for (size_t i = completions; i < sample.size(); ++i) {
+            app.removeTask(sample[i]);
+        }
+        if (removals > 0) {
+            report("removeTask", taskCount, removals, millisecondsSince(start));
+        }
+
+        start = Clock::now();
+        app.clearCompleted();
+        report("clearCompleted", taskCount, 1, millisecondsSince(start));
+        if (app.getTotalTasks() != static_cast<int>(taskCount - sample.size())) {
+            std::cout << "Error: " << app.getTotalTasks() << " tasks left after clearCompleted()." << std::endl;
+        }
+    }
+    std::remove(logFile.c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory = ".";
+    std::vector<size_t> taskCounts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (std::strtoul(arg.c_str(), nullptr, 10) > 0) {
+            taskCounts.push_back(std::strtoul(arg.c_str(), nullptr, 10));
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--dir DIRECTORY] [task count...]" << std::endl;
+            return 1;
+        }
+    }
+    if (taskCounts.empty()) {
+        taskCounts = {1000, 100000, 10000000};
+    }
+
+    std::cout << std::left << std::setw(22) << "operation"
+              << std::right << std::setw(10) << "tasks"
+              << std::setw(10) << "calls"
+              << std::setw(14) << "total ms"
+              << std::setw(16) << "ns/call" << std::endl;
+    for (size_t taskCount : taskCounts) {
+        runBenchmarks(taskCount, directory);
+    }
+    return 0;
+}